@@ -0,0 +1,439 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions benchmark
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+/* required for clock_gettime and getopt */
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "perf-counters.h"
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+
+/* skew of the zipfian distribution (YCSB default) */
+#define ZIPF_THETA 0.99
+
+static const struct bench_engine *engines[] = {
+	&bench_engine_rbtree,
+	&bench_engine_rbtree_inline,
+	&bench_engine_stdset,
+	&bench_engine_btree,
+};
+
+enum distribution {
+	DIST_SEQUENTIAL,
+	DIST_RANDOM,
+	DIST_ZIPFIAN,
+	DIST_COUNT
+};
+
+static const char *distribution_names[DIST_COUNT] = {
+	"sequential",
+	"random",
+	"zipfian",
+};
+
+/**
+ * struct zipf - generator for zipfian distributed ranks
+ * @n: number of ranks
+ * @theta: skew of the distribution
+ * @alpha: precalculated 1 / (1 - theta)
+ * @zetan: precalculated zeta(n, theta)
+ * @eta: precalculated scaling factor
+ *
+ * The ranks are generated using the algorithm from "Quickly Generating
+ * Billion-Record Synthetic Databases" (Gray et al.). Rank 0 is the most
+ * popular one.
+ */
+struct zipf {
+	uint64_t n;
+	double theta;
+	double alpha;
+	double zetan;
+	double eta;
+};
+
+/**
+ * struct keygen - generator for the keys of a workload
+ * @dist: distribution of the keys
+ * @n: number of different keys
+ * @pos: number of already generated keys
+ * @state: state of the pseudo random number generator
+ * @zipf: generator for zipfian distributed keys
+ */
+struct keygen {
+	enum distribution dist;
+	uint64_t n;
+	uint64_t pos;
+	uint64_t state;
+	struct zipf *zipf;
+};
+
+/**
+ * struct result - consistency information of a workload run
+ * @hits: number of successful operations
+ * @sum: checksum of the scan
+ */
+struct result {
+	uint64_t hits;
+	uint64_t sum;
+};
+
+/**
+ * struct measurement - running measurement of a workload
+ * @start: start time in ns
+ * @counters: hardware counters for the workload
+ */
+struct measurement {
+	uint64_t start;
+	struct perf_counters counters;
+};
+
+static int first_result = 1;
+
+static uint64_t random64(uint64_t *state)
+{
+	*state += 1;
+
+	return bench_mix64(*state ^ UINT64_C(0x5851f42d4c957f2d));
+}
+
+static double random_double(uint64_t *state)
+{
+	return (random64(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void zipf_init(struct zipf *zipf, uint64_t n, double theta)
+{
+	double zeta2;
+	uint64_t i;
+
+	zipf->n = n;
+	zipf->theta = theta;
+	zipf->alpha = 1.0 / (1.0 - theta);
+
+	zipf->zetan = 0.0;
+	for (i = 1; i <= n; i++)
+		zipf->zetan += 1.0 / pow((double)i, theta);
+
+	zeta2 = 1.0 + 1.0 / pow(2.0, theta);
+	zipf->eta = (1.0 - pow(2.0 / n, 1.0 - theta)) /
+		    (1.0 - zeta2 / zipf->zetan);
+}
+
+static uint64_t zipf_next(const struct zipf *zipf, uint64_t *state)
+{
+	double u = random_double(state);
+	double uz = u * zipf->zetan;
+	uint64_t rank;
+
+	if (uz < 1.0)
+		return 0;
+
+	if (uz < 1.0 + pow(0.5, zipf->theta))
+		return 1;
+
+	rank = (uint64_t)(zipf->n * pow(zipf->eta * u - zipf->eta + 1.0,
+					zipf->alpha));
+	if (rank >= zipf->n)
+		rank = zipf->n - 1;
+
+	return rank;
+}
+
+static void keygen_init(struct keygen *gen, enum distribution dist,
+			uint64_t n, uint64_t seed, struct zipf *zipf)
+{
+	gen->dist = dist;
+	gen->n = n;
+	gen->pos = 0;
+	gen->state = seed;
+	gen->zipf = zipf;
+}
+
+/**
+ * keygen_fill() - Get next key to fill the set
+ * @gen: key generator
+ *
+ * Sequential keys are ascending. Random keys are a permutation of n different
+ * keys. Zipfian keys are drawn with repetition from the same n keys.
+ *
+ * Return: next key
+ */
+static uint64_t keygen_fill(struct keygen *gen)
+{
+	uint64_t pos = gen->pos++;
+
+	switch (gen->dist) {
+	case DIST_SEQUENTIAL:
+		return pos;
+	case DIST_RANDOM:
+		return bench_mix64(pos);
+	case DIST_ZIPFIAN:
+	default:
+		return bench_mix64(zipf_next(gen->zipf, &gen->state));
+	}
+}
+
+/**
+ * keygen_access() - Get next key to access a filled set
+ * @gen: key generator
+ *
+ * Sequential keys are ascending. Random keys are uniformly drawn from the n
+ * keys. Zipfian keys are drawn with repetition from the same n keys.
+ *
+ * Return: next key
+ */
+static uint64_t keygen_access(struct keygen *gen)
+{
+	uint64_t pos = gen->pos++;
+
+	switch (gen->dist) {
+	case DIST_SEQUENTIAL:
+		return pos % gen->n;
+	case DIST_RANDOM:
+		return bench_mix64(random64(&gen->state) % gen->n);
+	case DIST_ZIPFIAN:
+	default:
+		return bench_mix64(zipf_next(gen->zipf, &gen->state));
+	}
+}
+
+static uint64_t time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+static void measure_start(struct measurement *measurement)
+{
+	perf_counters_start(&measurement->counters);
+	measurement->start = time_ns();
+}
+
+/**
+ * measure_stop() - Finish measurement of workload and report it
+ * @measurement: running measurement
+ * @engine: name of the set implementation
+ * @workload: name of the workload
+ * @dist: distribution of the keys
+ * @size: number of keys
+ * @ops: number of operations in the workload
+ */
+static void measure_stop(struct measurement *measurement, const char *engine,
+			 const char *workload, enum distribution dist,
+			 uint64_t size, uint64_t ops)
+{
+	uint64_t ns = time_ns() - measurement->start;
+	struct perf_values values;
+	double ns_per_op;
+	size_t i;
+
+	perf_counters_stop(&measurement->counters, &values);
+
+	if (!ops)
+		ops = 1;
+	ns_per_op = (double)ns / ops;
+
+	if (!first_result)
+		printf(",\n");
+	first_result = 0;
+
+	printf("    {\"engine\": \"%s\", \"workload\": \"%s\", "
+	       "\"distribution\": \"%s\", \"size\": %llu, \"ops\": %llu, "
+	       "\"ns_per_op\": %.3f",
+	       engine, workload, distribution_names[dist],
+	       (unsigned long long)size, (unsigned long long)ops, ns_per_op);
+
+	/* unavailable counters are reported as null */
+	for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+		printf(", \"%s_per_op\": ", perf_counter_names[i]);
+
+		if (values.valid[i])
+			printf("%.3f", (double)values.value[i] / ops);
+		else
+			printf("null");
+	}
+	printf("}");
+	fflush(stdout);
+
+	fprintf(stderr, "%-13s %-8s %-10s %10llu %10.2f ns/op", engine,
+		workload, distribution_names[dist], (unsigned long long)size,
+		ns_per_op);
+	for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+		if (values.valid[i])
+			fprintf(stderr, " %10.2f %s", (double)values.value[i] / ops,
+				perf_counter_names[i]);
+	}
+	fprintf(stderr, "\n");
+}
+
+/**
+ * run_engine() - Run all workloads for an engine
+ * @engine: set implementation
+ * @dist: distribution of the keys
+ * @n: number of keys
+ * @zipf: zipfian generator for @n keys
+ * @measurement: measurement state with opened counters
+ * @results: consistency information for each workload
+ */
+static void run_engine(const struct bench_engine *engine,
+		       enum distribution dist, uint64_t n, struct zipf *zipf,
+		       struct measurement *measurement, struct result *results)
+{
+	struct keygen gen;
+	uint64_t key;
+	uint64_t i;
+	void *set;
+
+	memset(results, 0, sizeof(*results) * 5);
+	set = engine->create();
+
+	/* insert */
+	keygen_init(&gen, dist, n, 1, zipf);
+	measure_start(measurement);
+	for (i = 0; i < n; i++)
+		results[0].hits += engine->insert(set, keygen_fill(&gen));
+	measure_stop(measurement, engine->name, "insert", dist, n, n);
+
+	/* lookup */
+	keygen_init(&gen, dist, n, 2, zipf);
+	measure_start(measurement);
+	for (i = 0; i < n; i++)
+		results[1].hits += engine->find(set, keygen_access(&gen));
+	measure_stop(measurement, engine->name, "lookup", dist, n, n);
+
+	/* full-scan */
+	measure_start(measurement);
+	results[2].sum = engine->scan(set);
+	measure_stop(measurement, engine->name, "scan", dist, n,
+		     results[0].hits);
+
+	/* mixed: 50% lookup, 25% insert, 25% erase */
+	keygen_init(&gen, dist, n, 3, zipf);
+	measure_start(measurement);
+	for (i = 0; i < n; i++) {
+		key = keygen_access(&gen);
+
+		switch (i % 4) {
+		case 0:
+		case 2:
+			results[3].hits += engine->find(set, key);
+			break;
+		case 1:
+			results[3].hits += engine->erase(set, key);
+			break;
+		case 3:
+			results[3].hits += engine->insert(set, key);
+			break;
+		}
+	}
+	measure_stop(measurement, engine->name, "mixed", dist, n, n);
+
+	/* erase - use the keys of the insert workload */
+	keygen_init(&gen, dist, n, 1, zipf);
+	measure_start(measurement);
+	for (i = 0; i < n; i++)
+		results[4].hits += engine->erase(set, keygen_fill(&gen));
+	measure_stop(measurement, engine->name, "erase", dist, n, n);
+
+	engine->destroy(set);
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-m MAXSIZE] [-e ENGINE]\n", name);
+	fprintf(stderr, "  -m MAXSIZE  largest number of keys (default 1000000)\n");
+	fprintf(stderr, "  -e ENGINE   only run selected engine (rbtree, rbtree-inline, std::set, btree)\n");
+}
+
+int main(int argc, char *argv[])
+{
+	struct result results[ARRAY_SIZE(engines)][5];
+	const char *engine_filter = NULL;
+	struct measurement measurement;
+	uint64_t maxsize = 1000000;
+	enum distribution dist;
+	struct zipf zipf;
+	uint64_t size;
+	size_t i, j;
+	int ret = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "m:e:h")) != -1) {
+		switch (opt) {
+		case 'm':
+			maxsize = strtoull(optarg, NULL, 0);
+			break;
+		case 'e':
+			engine_filter = optarg;
+			break;
+		case 'h':
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	perf_counters_open(&measurement.counters);
+	for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+		if (measurement.counters.fd[i] < 0)
+			fprintf(stderr, "hardware counter %s not available\n",
+				perf_counter_names[i]);
+	}
+
+	printf("{\n  \"benchmarks\": [\n");
+
+	for (size = 1000; size <= maxsize; size *= 10) {
+		zipf_init(&zipf, size, ZIPF_THETA);
+
+		for (dist = DIST_SEQUENTIAL; dist < DIST_COUNT;
+		     dist = (enum distribution)(dist + 1)) {
+			for (i = 0; i < ARRAY_SIZE(engines); i++) {
+				if (engine_filter &&
+				    strcmp(engine_filter, engines[i]->name) != 0)
+					continue;
+
+				run_engine(engines[i], dist, size, &zipf,
+					   &measurement, results[i]);
+			}
+
+			/* all engines must have seen the same set content */
+			for (i = 1; !engine_filter && i < ARRAY_SIZE(engines); i++) {
+				for (j = 0; j < 5; j++) {
+					if (results[i][j].hits == results[0][j].hits &&
+					    results[i][j].sum == results[0][j].sum)
+						continue;
+
+					fprintf(stderr,
+						"%s differs from %s for %s/%llu\n",
+						engines[i]->name,
+						engines[0]->name,
+						distribution_names[dist],
+						(unsigned long long)size);
+					ret = 1;
+				}
+			}
+		}
+	}
+
+	printf("\n  ]\n}\n");
+
+	perf_counters_close(&measurement.counters);
+
+	return ret;
+}
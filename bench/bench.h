@@ -0,0 +1,66 @@
+/* SPDX-License-Identifier: MIT */
+/* Minimal red-black-tree helper functions benchmark
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#ifndef __RBTREE_BENCH_H__
+#define __RBTREE_BENCH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * struct bench_engine - ordered set implementation under test
+ * @name: name of the implementation in the results
+ * @create: allocate new empty set
+ * @destroy: free set and all of its entries
+ * @insert: add key to set. Return 1 when key was added, 0 when it already
+ *  existed
+ * @find: search key in set. Return 1 when key was found, 0 otherwise
+ * @erase: remove key from set. Return 1 when key was removed, 0 when it didn't
+ *  exist
+ * @scan: iterate over all entries in order. Return sum of all keys
+ */
+struct bench_engine {
+	const char *name;
+	void *(*create)(void);
+	void (*destroy)(void *set);
+	int (*insert)(void *set, uint64_t key);
+	int (*find)(void *set, uint64_t key);
+	int (*erase)(void *set, uint64_t key);
+	uint64_t (*scan)(void *set);
+};
+
+/**
+ * bench_mix64() - Map integer to pseudo random integer
+ * @x: integer to map
+ *
+ * The splitmix64 finalizer is bijective. Different ranks are therefore always
+ * mapped to different keys.
+ *
+ * Return: mapped integer
+ */
+static __inline__ uint64_t bench_mix64(uint64_t x)
+{
+	x += UINT64_C(0x9e3779b97f4a7c15);
+	x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+	x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+
+	return x ^ (x >> 31);
+}
+
+extern const struct bench_engine bench_engine_rbtree;
+extern const struct bench_engine bench_engine_rbtree_inline;
+extern const struct bench_engine bench_engine_stdset;
+extern const struct bench_engine bench_engine_btree;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RBTREE_BENCH_H__ */
@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions instruction count benchmark
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "bench.h"
+
+#if defined(__GNUC__)
+#define CACHEGRIND_NOINLINE __attribute__((noinline))
+#else
+#define CACHEGRIND_NOINLINE
+#endif
+
+/**
+ * struct cg_item - entry in the measured tree
+ * @key: key of the entry
+ * @rb: node in the tree
+ */
+struct cg_item {
+	uint64_t key;
+	struct rb_node rb;
+};
+
+enum cg_workload {
+	CG_INSERT,
+	CG_FIND,
+	CG_ERASE,
+	CG_ITERATE,
+	CG_WORKLOAD_COUNT
+};
+
+static const char *cg_workload_names[CG_WORKLOAD_COUNT] = {
+	"insert",
+	"find",
+	"erase",
+	"iterate",
+};
+
+static void cg_insert(struct rb_root *root, struct cg_item *item)
+{
+	RB_LINK *rb_link = &root->node;
+	struct rb_node *parent = NULL;
+	struct rb_node *node;
+	struct cg_item *cur_entry;
+
+	while ((node = rb_link_get(rb_link))) {
+		cur_entry = rb_entry(node, struct cg_item, rb);
+
+		parent = node;
+		if (item->key < cur_entry->key)
+			rb_link = &node->left;
+		else
+			rb_link = &node->right;
+	}
+
+	rb_insert(&item->rb, parent, rb_link, root);
+}
+
+static struct cg_item *cg_find(struct rb_root *root, uint64_t key)
+{
+	struct rb_node *node = rb_link_get(&root->node);
+	struct cg_item *cur_entry;
+
+	while (node) {
+		cur_entry = rb_entry(node, struct cg_item, rb);
+
+		if (key == cur_entry->key)
+			return cur_entry;
+
+		if (key < cur_entry->key)
+			node = rb_left(node);
+		else
+			node = rb_right(node);
+	}
+
+	return NULL;
+}
+
+/**
+ * cachegrind_workload() - Run the measured part of a workload
+ * @workload: selected workload
+ * @root: tree prepared for the workload
+ * @items: all items of the workload
+ * @n: number of items
+ *
+ * Only this function is measured (callgrind --toggle-collect). It must
+ * therefore never be inlined.
+ *
+ * Return: checksum of the workload
+ */
+static CACHEGRIND_NOINLINE uint64_t
+cachegrind_workload(enum cg_workload workload, struct rb_root *root,
+		    struct cg_item *items, size_t n)
+{
+	struct cg_item *item;
+	struct rb_node *node;
+	uint64_t sum = 0;
+	size_t i;
+
+	switch (workload) {
+	case CG_INSERT:
+		for (i = 0; i < n; i++)
+			cg_insert(root, &items[i]);
+		break;
+	case CG_FIND:
+		for (i = 0; i < n; i++) {
+			item = cg_find(root, items[n - i - 1].key);
+			if (item)
+				sum += item->key;
+		}
+		break;
+	case CG_ERASE:
+		for (i = 0; i < n; i++) {
+			item = cg_find(root, items[i].key);
+			if (!item)
+				continue;
+
+			rb_erase(&item->rb, root);
+			sum++;
+		}
+		break;
+	case CG_ITERATE:
+	default:
+		for (node = rb_first(root); node; node = rb_next(node))
+			sum += rb_entry(node, struct cg_item, rb)->key;
+		break;
+	}
+
+	return sum;
+}
+
+int main(int argc, char *argv[])
+{
+	enum cg_workload workload;
+	struct cg_item *items;
+	struct rb_root root;
+	size_t n = 100000;
+	uint64_t sum;
+	size_t i;
+
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "Usage: %s WORKLOAD [COUNT]\n", argv[0]);
+		fprintf(stderr, "  WORKLOAD  insert, find, erase or iterate\n");
+		fprintf(stderr, "  COUNT     number of keys (default 100000)\n");
+		return 1;
+	}
+
+	for (workload = CG_INSERT; workload < CG_WORKLOAD_COUNT;
+	     workload = (enum cg_workload)(workload + 1)) {
+		if (strcmp(argv[1], cg_workload_names[workload]) == 0)
+			break;
+	}
+
+	if (workload == CG_WORKLOAD_COUNT) {
+		fprintf(stderr, "unknown workload %s\n", argv[1]);
+		return 1;
+	}
+
+	if (argc == 3)
+		n = (size_t)strtoull(argv[2], NULL, 0);
+
+	/* preallocated to get the same memory layout in each run */
+	items = (struct cg_item *)malloc(sizeof(*items) * (n ? n : 1));
+	if (!items)
+		return 1;
+
+	for (i = 0; i < n; i++)
+		items[i].key = bench_mix64(i);
+
+	INIT_RB_ROOT(&root);
+	if (workload != CG_INSERT) {
+		for (i = 0; i < n; i++)
+			cg_insert(&root, &items[i]);
+	}
+
+	sum = cachegrind_workload(workload, &root, items, n);
+	printf("%s %llu %llu\n", cg_workload_names[workload],
+	       (unsigned long long)n, (unsigned long long)sum);
+
+	free(items);
+
+	return 0;
+}
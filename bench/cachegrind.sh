@@ -0,0 +1,136 @@
+#!/bin/sh
+# SPDX-License-Identifier: MIT
+#
+# Minimal red-black-tree helper functions instruction count benchmark
+#
+# SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+#
+# Usage: cachegrind.sh [-u] BINARY BASELINE
+#
+# Runs each workload of BINARY under callgrind with cache and branch
+# simulation. Only the cachegrind_workload() function is measured. The costs
+# per operation are compared against BASELINE. The check fails when a metric
+# grows more than its tolerance or when a workload or metric is missing in
+# either the results or BASELINE. With -u, BASELINE is rewritten with the new
+# results (tolerances and comments are kept).
+
+set -e
+
+update=0
+if [ "$1" = "-u" ]; then
+	update=1
+	shift
+fi
+
+if [ "$#" -ne 2 ]; then
+	echo "Usage: $0 [-u] BINARY BASELINE" >&2
+	exit 1
+fi
+
+binary="$1"
+baseline="$2"
+count="${CACHEGRIND_COUNT:-100000}"
+valgrind="${VALGRIND:-valgrind}"
+
+if ! command -v "${valgrind}" > /dev/null 2>&1; then
+	echo "${valgrind} not found" >&2
+	exit 1
+fi
+
+tmpdir="$(mktemp -d)"
+trap 'rm -rf "${tmpdir}"' EXIT
+
+for workload in insert find erase iterate; do
+	"${valgrind}" -q --tool=callgrind --cache-sim=yes --branch-sim=yes \
+		--toggle-collect=cachegrind_workload \
+		--callgrind-out-file="${tmpdir}/callgrind.out" \
+		"${binary}" "${workload}" "${count}" > /dev/null
+
+	awk -v workload="${workload}" -v count="${count}" '
+		/^events:/ {
+			for (i = 2; i <= NF; i++)
+				idx[$i] = i - 1
+		}
+		/^(summary|totals):/ {
+			for (i = 2; i <= NF; i++)
+				val[i - 1] = $i
+		}
+		END {
+			split("Ir D1mr D1mw DLmr DLmw Bc Bi Bcm Bim", events)
+			for (i in events) {
+				if (events[i] in idx)
+					continue
+
+				printf "%s: no %s in callgrind output\n",
+				       workload, events[i] > "/dev/stderr"
+				exit 1
+			}
+
+			printf "%s instructions %.3f\n", workload,
+			       val[idx["Ir"]] / count
+			printf "%s d1_misses %.3f\n", workload,
+			       (val[idx["D1mr"]] + val[idx["D1mw"]]) / count
+			printf "%s ll_misses %.3f\n", workload,
+			       (val[idx["DLmr"]] + val[idx["DLmw"]]) / count
+			printf "%s branches %.3f\n", workload,
+			       (val[idx["Bc"]] + val[idx["Bi"]]) / count
+			printf "%s branch_misses %.3f\n", workload,
+			       (val[idx["Bcm"]] + val[idx["Bim"]]) / count
+		}' "${tmpdir}/callgrind.out" >> "${tmpdir}/results"
+done
+
+if [ "${update}" = "1" ]; then
+	grep -E '^(#|tolerance )' "${baseline}" > "${tmpdir}/baseline" || true
+	cat "${tmpdir}/results" >> "${tmpdir}/baseline"
+	cp "${tmpdir}/baseline" "${baseline}"
+	cat "${tmpdir}/results"
+	exit 0
+fi
+
+awk '
+	NR == FNR {
+		if ($1 == "tolerance")
+			tolerance[$2] = $3
+		else if ($0 !~ /^#/ && NF == 3)
+			base[$1 " " $2] = $3
+		next
+	}
+	{
+		key = $1 " " $2
+		seen[key] = 1
+		if (!(key in base)) {
+			printf "%-8s %-14s %12.3f (no baseline) MISSING\n",
+			       $1, $2, $3
+			missing = 1
+			next
+		}
+
+		tol = ($2 in tolerance) ? tolerance[$2] : 0
+		diff = base[key] ? ($3 - base[key]) * 100.0 / base[key] : 0
+		status = "ok"
+		if (diff > tol) {
+			status = "REGRESSION"
+			failed = 1
+		} else if (diff < -tol) {
+			status = "improved (update baseline)"
+		}
+
+		printf "%-8s %-14s %12.3f %12.3f %+7.2f%% (+-%s%%) %s\n",
+		       $1, $2, $3, base[key], diff, tol, status
+	}
+	END {
+		for (key in base) {
+			if (key in seen)
+				continue
+
+			split(key, name, " ")
+			printf "%-8s %-14s (no result) MISSING\n",
+			       name[1], name[2]
+			missing = 1
+		}
+
+		if (missing)
+			print "baseline incomplete, record it with " \
+			      "\"make cachegrind-baseline\"" > "/dev/stderr"
+		exit failed || missing
+	}' "${baseline}" "${tmpdir}/results"
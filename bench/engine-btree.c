@@ -0,0 +1,442 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions benchmark
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+/* minimum degree - nodes (except root) have between T-1 and 2T-1 keys */
+#define BTREE_T 16
+#define BTREE_MAX_KEYS (2 * BTREE_T - 1)
+
+/**
+ * struct btree_node - node of the B-tree
+ * @nkeys: number of used entries in @keys
+ * @leaf: node has no children
+ * @keys: sorted keys stored in the node
+ *
+ * Leaf nodes are allocated without children array. This keeps most of the
+ * nodes compact like in the abseil B-tree containers.
+ */
+struct btree_node {
+	unsigned int nkeys;
+	int leaf;
+	uint64_t keys[BTREE_MAX_KEYS];
+};
+
+/**
+ * struct btree_inner - inner node of the B-tree
+ * @node: common node data
+ * @children: subtrees between the keys
+ */
+struct btree_inner {
+	struct btree_node node;
+	struct btree_node *children[BTREE_MAX_KEYS + 1];
+};
+
+struct btree {
+	struct btree_node *root;
+};
+
+static struct btree_node **btree_children(struct btree_node *node)
+{
+	return ((struct btree_inner *)node)->children;
+}
+
+static struct btree_node *btree_node_alloc(int leaf)
+{
+	struct btree_node *node;
+
+	if (leaf)
+		node = (struct btree_node *)malloc(sizeof(struct btree_node));
+	else
+		node = (struct btree_node *)malloc(sizeof(struct btree_inner));
+	if (!node)
+		abort();
+
+	node->nkeys = 0;
+	node->leaf = leaf;
+
+	return node;
+}
+
+static void btree_node_free(struct btree_node *node)
+{
+	unsigned int i;
+
+	if (!node->leaf) {
+		for (i = 0; i <= node->nkeys; i++)
+			btree_node_free(btree_children(node)[i]);
+	}
+
+	free(node);
+}
+
+/**
+ * btree_lower_bound() - Find position of first key not smaller than key
+ * @node: node to search in
+ * @key: key to search for
+ *
+ * Return: index of first key not smaller than @key, @node->nkeys when all are
+ *  smaller
+ */
+static unsigned int btree_lower_bound(const struct btree_node *node,
+				      uint64_t key)
+{
+	unsigned int low = 0;
+	unsigned int high = node->nkeys;
+	unsigned int mid;
+
+	while (low < high) {
+		mid = (low + high) / 2;
+
+		if (node->keys[mid] < key)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+/**
+ * btree_split_child() - Split full child into two nodes
+ * @parent: non-full parent of the full child
+ * @pos: index of the full child in @parent
+ */
+static void btree_split_child(struct btree_node *parent, unsigned int pos)
+{
+	struct btree_node **children = btree_children(parent);
+	struct btree_node *child = children[pos];
+	struct btree_node *sibling;
+
+	sibling = btree_node_alloc(child->leaf);
+	sibling->nkeys = BTREE_T - 1;
+	memcpy(sibling->keys, &child->keys[BTREE_T],
+	       sizeof(child->keys[0]) * (BTREE_T - 1));
+	if (!child->leaf)
+		memcpy(btree_children(sibling), &btree_children(child)[BTREE_T],
+		       sizeof(children[0]) * BTREE_T);
+	child->nkeys = BTREE_T - 1;
+
+	/* move median key to parent */
+	memmove(&children[pos + 2], &children[pos + 1],
+		sizeof(children[0]) * (parent->nkeys - pos));
+	memmove(&parent->keys[pos + 1], &parent->keys[pos],
+		sizeof(parent->keys[0]) * (parent->nkeys - pos));
+	children[pos + 1] = sibling;
+	parent->keys[pos] = child->keys[BTREE_T - 1];
+	parent->nkeys++;
+}
+
+/**
+ * btree_merge_children() - Merge two children and the key between them
+ * @parent: parent of both children
+ * @pos: index of the left child in @parent
+ *
+ * Both children must have the minimum number of keys.
+ */
+static void btree_merge_children(struct btree_node *parent, unsigned int pos)
+{
+	struct btree_node **children = btree_children(parent);
+	struct btree_node *child = children[pos];
+	struct btree_node *sibling = children[pos + 1];
+
+	child->keys[child->nkeys] = parent->keys[pos];
+	memcpy(&child->keys[child->nkeys + 1], sibling->keys,
+	       sizeof(sibling->keys[0]) * sibling->nkeys);
+	if (!child->leaf)
+		memcpy(&btree_children(child)[child->nkeys + 1],
+		       btree_children(sibling),
+		       sizeof(children[0]) * (sibling->nkeys + 1));
+	child->nkeys += sibling->nkeys + 1;
+
+	memmove(&parent->keys[pos], &parent->keys[pos + 1],
+		sizeof(parent->keys[0]) * (parent->nkeys - pos - 1));
+	memmove(&children[pos + 1], &children[pos + 2],
+		sizeof(children[0]) * (parent->nkeys - pos - 1));
+	parent->nkeys--;
+
+	free(sibling);
+}
+
+/**
+ * btree_borrow_left() - Move key from left sibling via parent to child
+ * @parent: parent of the child
+ * @pos: index of the child in @parent
+ */
+static void btree_borrow_left(struct btree_node *parent, unsigned int pos)
+{
+	struct btree_node *child = btree_children(parent)[pos];
+	struct btree_node *sibling = btree_children(parent)[pos - 1];
+	struct btree_node **child_children;
+
+	memmove(&child->keys[1], child->keys,
+		sizeof(child->keys[0]) * child->nkeys);
+	child->keys[0] = parent->keys[pos - 1];
+	parent->keys[pos - 1] = sibling->keys[sibling->nkeys - 1];
+
+	if (!child->leaf) {
+		child_children = btree_children(child);
+		memmove(&child_children[1], child_children,
+			sizeof(child_children[0]) * (child->nkeys + 1));
+		child_children[0] = btree_children(sibling)[sibling->nkeys];
+	}
+
+	child->nkeys++;
+	sibling->nkeys--;
+}
+
+/**
+ * btree_borrow_right() - Move key from right sibling via parent to child
+ * @parent: parent of the child
+ * @pos: index of the child in @parent
+ */
+static void btree_borrow_right(struct btree_node *parent, unsigned int pos)
+{
+	struct btree_node *child = btree_children(parent)[pos];
+	struct btree_node *sibling = btree_children(parent)[pos + 1];
+	struct btree_node **sibling_children;
+
+	child->keys[child->nkeys] = parent->keys[pos];
+	parent->keys[pos] = sibling->keys[0];
+	memmove(sibling->keys, &sibling->keys[1],
+		sizeof(sibling->keys[0]) * (sibling->nkeys - 1));
+
+	if (!child->leaf) {
+		sibling_children = btree_children(sibling);
+		btree_children(child)[child->nkeys + 1] = sibling_children[0];
+		memmove(sibling_children, &sibling_children[1],
+			sizeof(sibling_children[0]) * sibling->nkeys);
+	}
+
+	child->nkeys++;
+	sibling->nkeys--;
+}
+
+/**
+ * btree_fill_child() - Make sure that child can lose a key
+ * @parent: parent of the child
+ * @pos: index of the child in @parent
+ *
+ * Return: index of the child which contains the keys of the original child
+ */
+static unsigned int btree_fill_child(struct btree_node *parent,
+				     unsigned int pos)
+{
+	struct btree_node **children = btree_children(parent);
+
+	if (children[pos]->nkeys >= BTREE_T)
+		return pos;
+
+	if (pos > 0 && children[pos - 1]->nkeys >= BTREE_T) {
+		btree_borrow_left(parent, pos);
+		return pos;
+	}
+
+	if (pos < parent->nkeys && children[pos + 1]->nkeys >= BTREE_T) {
+		btree_borrow_right(parent, pos);
+		return pos;
+	}
+
+	/* merge with a sibling */
+	if (pos < parent->nkeys) {
+		btree_merge_children(parent, pos);
+		return pos;
+	}
+
+	btree_merge_children(parent, pos - 1);
+	return pos - 1;
+}
+
+static void *btree_create(void)
+{
+	struct btree *tree;
+
+	tree = (struct btree *)malloc(sizeof(*tree));
+	if (!tree)
+		abort();
+
+	tree->root = btree_node_alloc(1);
+
+	return tree;
+}
+
+static void btree_destroy(void *set)
+{
+	struct btree *tree = (struct btree *)set;
+
+	btree_node_free(tree->root);
+	free(tree);
+}
+
+static int btree_insert(void *set, uint64_t key)
+{
+	struct btree *tree = (struct btree *)set;
+	struct btree_node *node = tree->root;
+	unsigned int pos;
+
+	/* split full nodes on the way down to always have room for a key */
+	if (node->nkeys == BTREE_MAX_KEYS) {
+		node = btree_node_alloc(0);
+		btree_children(node)[0] = tree->root;
+		tree->root = node;
+		btree_split_child(node, 0);
+	}
+
+	while (1) {
+		pos = btree_lower_bound(node, key);
+		if (pos < node->nkeys && node->keys[pos] == key)
+			return 0;
+
+		if (node->leaf)
+			break;
+
+		if (btree_children(node)[pos]->nkeys == BTREE_MAX_KEYS) {
+			btree_split_child(node, pos);
+
+			if (node->keys[pos] == key)
+				return 0;
+
+			if (node->keys[pos] < key)
+				pos++;
+		}
+
+		node = btree_children(node)[pos];
+	}
+
+	memmove(&node->keys[pos + 1], &node->keys[pos],
+		sizeof(node->keys[0]) * (node->nkeys - pos));
+	node->keys[pos] = key;
+	node->nkeys++;
+
+	return 1;
+}
+
+static int btree_find(void *set, uint64_t key)
+{
+	struct btree *tree = (struct btree *)set;
+	struct btree_node *node = tree->root;
+	unsigned int pos;
+
+	while (1) {
+		pos = btree_lower_bound(node, key);
+		if (pos < node->nkeys && node->keys[pos] == key)
+			return 1;
+
+		if (node->leaf)
+			return 0;
+
+		node = btree_children(node)[pos];
+	}
+}
+
+static int btree_erase(void *set, uint64_t key)
+{
+	struct btree *tree = (struct btree *)set;
+	struct btree_node *node = tree->root;
+	struct btree_node **children;
+	struct btree_node *child;
+	unsigned int pos;
+	int found = 0;
+
+	/* fill nodes on the way down to always be able to remove a key */
+	while (1) {
+		pos = btree_lower_bound(node, key);
+
+		if (pos < node->nkeys && node->keys[pos] == key) {
+			found = 1;
+
+			if (node->leaf) {
+				memmove(&node->keys[pos], &node->keys[pos + 1],
+					sizeof(node->keys[0]) *
+					(node->nkeys - pos - 1));
+				node->nkeys--;
+				break;
+			}
+
+			children = btree_children(node);
+			if (children[pos]->nkeys >= BTREE_T) {
+				/* replace with predecessor and remove it */
+				child = children[pos];
+				while (!child->leaf)
+					child = btree_children(child)[child->nkeys];
+
+				key = child->keys[child->nkeys - 1];
+				node->keys[pos] = key;
+				node = children[pos];
+			} else if (children[pos + 1]->nkeys >= BTREE_T) {
+				/* replace with successor and remove it */
+				child = children[pos + 1];
+				while (!child->leaf)
+					child = btree_children(child)[0];
+
+				key = child->keys[0];
+				node->keys[pos] = key;
+				node = children[pos + 1];
+			} else {
+				/* move key down into merged child */
+				btree_merge_children(node, pos);
+				node = children[pos];
+			}
+
+			continue;
+		}
+
+		if (node->leaf)
+			break;
+
+		pos = btree_fill_child(node, pos);
+		node = btree_children(node)[pos];
+	}
+
+	/* drop empty root */
+	node = tree->root;
+	if (node->nkeys == 0 && !node->leaf) {
+		tree->root = btree_children(node)[0];
+		free(node);
+	}
+
+	return found;
+}
+
+static uint64_t btree_scan_node(struct btree_node *node)
+{
+	uint64_t sum = 0;
+	unsigned int i;
+
+	for (i = 0; i < node->nkeys; i++) {
+		if (!node->leaf)
+			sum += btree_scan_node(btree_children(node)[i]);
+
+		sum += node->keys[i];
+	}
+
+	if (!node->leaf)
+		sum += btree_scan_node(btree_children(node)[node->nkeys]);
+
+	return sum;
+}
+
+static uint64_t btree_scan(void *set)
+{
+	struct btree *tree = (struct btree *)set;
+
+	return btree_scan_node(tree->root);
+}
+
+const struct bench_engine bench_engine_btree = {
+	"btree",
+	btree_create,
+	btree_destroy,
+	btree_insert,
+	btree_find,
+	btree_erase,
+	btree_scan,
+};
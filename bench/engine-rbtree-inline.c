@@ -0,0 +1,12 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions benchmark
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+/* rbtree engine with the header-only implementation */
+#define RBTREE_INLINE
+#define BENCH_ENGINE_RBTREE bench_engine_rbtree_inline
+#define BENCH_ENGINE_RBTREE_NAME "rbtree-inline"
+
+#include "engine-rbtree.c"
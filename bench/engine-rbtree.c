@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions benchmark
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "../rbtree.h"
+#include "bench.h"
+
+/* engine-rbtree-inline.c reuses this engine with RBTREE_INLINE */
+#ifndef BENCH_ENGINE_RBTREE
+#define BENCH_ENGINE_RBTREE bench_engine_rbtree
+#define BENCH_ENGINE_RBTREE_NAME "rbtree"
+#endif
+
+struct rbbench_item {
+	uint64_t key;
+	struct rb_node rb;
+};
+
+static void *rbbench_create(void)
+{
+	struct rb_root *root;
+
+	root = (struct rb_root *)malloc(sizeof(*root));
+	if (root)
+		INIT_RB_ROOT(root);
+
+	return root;
+}
+
+static void rbbench_destroy(void *set)
+{
+	struct rb_root *root = (struct rb_root *)set;
+	struct rb_node *node = rb_link_get(&root->node);
+	struct rb_node *parent;
+
+	/* free leafs first to never access freed parents */
+	while (node) {
+		if (rb_left(node)) {
+			node = rb_left(node);
+			continue;
+		}
+
+		if (rb_right(node)) {
+			node = rb_right(node);
+			continue;
+		}
+
+		parent = rb_parent(node);
+		if (parent) {
+			if (rb_left(parent) == node)
+				rb_link_set(&parent->left, NULL);
+			else
+				rb_link_set(&parent->right, NULL);
+		}
+
+		free(rb_entry(node, struct rbbench_item, rb));
+		node = parent;
+	}
+
+	free(root);
+}
+
+static int rbbench_insert(void *set, uint64_t key)
+{
+	struct rb_root *root = (struct rb_root *)set;
+	RB_LINK *rb_link = &root->node;
+	struct rb_node *parent = NULL;
+	struct rb_node *node;
+	struct rbbench_item *cur_entry;
+	struct rbbench_item *new_entry;
+
+	while ((node = rb_link_get(rb_link))) {
+		cur_entry = rb_entry(node, struct rbbench_item, rb);
+
+		parent = node;
+		if (key == cur_entry->key)
+			return 0;
+
+		if (key < cur_entry->key)
+			rb_link = &node->left;
+		else
+			rb_link = &node->right;
+	}
+
+	new_entry = (struct rbbench_item *)malloc(sizeof(*new_entry));
+	if (!new_entry)
+		abort();
+
+	new_entry->key = key;
+	rb_insert(&new_entry->rb, parent, rb_link, root);
+
+	return 1;
+}
+
+static struct rbbench_item *rbbench_search(struct rb_root *root, uint64_t key)
+{
+	struct rb_node *node = rb_link_get(&root->node);
+	struct rbbench_item *cur_entry;
+
+	while (node) {
+		cur_entry = rb_entry(node, struct rbbench_item, rb);
+
+		if (key == cur_entry->key)
+			return cur_entry;
+
+		if (key < cur_entry->key)
+			node = rb_left(node);
+		else
+			node = rb_right(node);
+	}
+
+	return NULL;
+}
+
+static int rbbench_find(void *set, uint64_t key)
+{
+	return !!rbbench_search((struct rb_root *)set, key);
+}
+
+static int rbbench_erase(void *set, uint64_t key)
+{
+	struct rb_root *root = (struct rb_root *)set;
+	struct rbbench_item *item;
+
+	item = rbbench_search(root, key);
+	if (!item)
+		return 0;
+
+	rb_erase(&item->rb, root);
+	free(item);
+
+	return 1;
+}
+
+static uint64_t rbbench_scan(void *set)
+{
+	struct rb_root *root = (struct rb_root *)set;
+	struct rb_node *node;
+	uint64_t sum = 0;
+
+	for (node = rb_first(root); node; node = rb_next(node))
+		sum += rb_entry(node, struct rbbench_item, rb)->key;
+
+	return sum;
+}
+
+const struct bench_engine BENCH_ENGINE_RBTREE = {
+	BENCH_ENGINE_RBTREE_NAME,
+	rbbench_create,
+	rbbench_destroy,
+	rbbench_insert,
+	rbbench_find,
+	rbbench_erase,
+	rbbench_scan,
+};
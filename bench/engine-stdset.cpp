@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions benchmark
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <set>
+#include <stdint.h>
+
+#include "bench.h"
+
+typedef std::set<uint64_t> stdset;
+
+static void *stdset_create(void)
+{
+	return new stdset();
+}
+
+static void stdset_destroy(void *set)
+{
+	delete static_cast<stdset *>(set);
+}
+
+static int stdset_insert(void *set, uint64_t key)
+{
+	return static_cast<stdset *>(set)->insert(key).second;
+}
+
+static int stdset_find(void *set, uint64_t key)
+{
+	stdset *s = static_cast<stdset *>(set);
+
+	return s->find(key) != s->end();
+}
+
+static int stdset_erase(void *set, uint64_t key)
+{
+	return static_cast<stdset *>(set)->erase(key) != 0;
+}
+
+static uint64_t stdset_scan(void *set)
+{
+	stdset *s = static_cast<stdset *>(set);
+	uint64_t sum = 0;
+
+	for (stdset::const_iterator it = s->begin(); it != s->end(); ++it)
+		sum += *it;
+
+	return sum;
+}
+
+extern "C" const struct bench_engine bench_engine_stdset = {
+	"std::set",
+	stdset_create,
+	stdset_destroy,
+	stdset_insert,
+	stdset_find,
+	stdset_erase,
+	stdset_scan,
+};
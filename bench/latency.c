@@ -0,0 +1,486 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions latency benchmark
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+/* required for clock_gettime and getopt */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../rbtree.h"
+#include "bench.h"
+
+/* linear sub-buckets for each power of two (~6% relative error) */
+#define LATENCY_SUB_BITS 4
+#define LATENCY_SUB_BUCKETS (1u << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+/**
+ * struct latency_item - entry in the measured tree
+ * @key: key of the entry
+ * @rb: node in the tree
+ */
+struct latency_item {
+	uint64_t key;
+	struct rb_node rb;
+};
+
+/**
+ * struct latency_hist - histogram of operation latencies
+ * @count: number of samples for each bucket
+ * @total: number of samples
+ * @sum: sum of all sampled latencies in ns
+ * @max: largest sampled latency in ns
+ */
+struct latency_hist {
+	uint64_t count[LATENCY_BUCKETS];
+	uint64_t total;
+	uint64_t sum;
+	uint64_t max;
+};
+
+/**
+ * enum order - order in which the keys are processed
+ * @ORDER_RANDOM: random permutation of the keys
+ * @ORDER_ASCENDING: smallest key first
+ * @ORDER_DESCENDING: largest key first
+ *
+ * Ascending inserts always add to the right spine of the tree. The
+ * rb_insert_color() color flips then regularly split 4-nodes up to the root.
+ * Ascending/descending erases always remove the leftmost/rightmost node. The
+ * erase rebalance then climbs via the recolor cases whenever the spine is
+ * built from 2-nodes.
+ */
+enum order {
+	ORDER_RANDOM,
+	ORDER_ASCENDING,
+	ORDER_DESCENDING,
+	ORDER_COUNT
+};
+
+static const char *order_names[ORDER_COUNT] = {
+	"random",
+	"ascending",
+	"descending",
+};
+
+static int first_result = 1;
+
+static uint64_t time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+static size_t latency_bucket(uint64_t ns)
+{
+	unsigned int msb = 0;
+
+	if (ns < LATENCY_SUB_BUCKETS)
+		return (size_t)ns;
+
+	while (ns >> (msb + 1))
+		msb++;
+
+	return (msb - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS +
+	       ((ns >> (msb - LATENCY_SUB_BITS)) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+/**
+ * latency_bucket_max() - Get largest latency of a histogram bucket
+ * @bucket: index of the bucket
+ *
+ * Return: largest latency in ns which is sorted in @bucket
+ */
+static uint64_t latency_bucket_max(size_t bucket)
+{
+	size_t group = bucket / LATENCY_SUB_BUCKETS;
+	uint64_t sub = bucket % LATENCY_SUB_BUCKETS;
+	unsigned int shift;
+
+	if (group == 0)
+		return sub;
+
+	shift = (unsigned int)group - 1;
+
+	return ((LATENCY_SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+static void latency_record(struct latency_hist *hist, uint64_t ns)
+{
+	hist->count[latency_bucket(ns)]++;
+	hist->total++;
+	hist->sum += ns;
+	if (ns > hist->max)
+		hist->max = ns;
+}
+
+/**
+ * latency_percentile() - Get latency below which a fraction of samples lies
+ * @hist: histogram of the latencies
+ * @fraction: fraction of samples (0.0 to 1.0)
+ *
+ * Return: upper bound of the bucket containing the percentile in ns
+ */
+static uint64_t latency_percentile(const struct latency_hist *hist,
+				   double fraction)
+{
+	uint64_t rank = (uint64_t)(fraction * hist->total);
+	uint64_t seen = 0;
+	uint64_t value;
+	size_t i;
+
+	if (rank < fraction * hist->total)
+		rank++;
+	if (rank == 0)
+		rank = 1;
+
+	for (i = 0; i < LATENCY_BUCKETS; i++) {
+		seen += hist->count[i];
+		if (seen < rank)
+			continue;
+
+		value = latency_bucket_max(i);
+		if (value > hist->max)
+			value = hist->max;
+
+		return value;
+	}
+
+	return hist->max;
+}
+
+static void latency_report(const struct latency_hist *hist,
+			   const char *workload, enum order order,
+			   uint64_t size)
+{
+	uint64_t p50 = latency_percentile(hist, 0.50);
+	uint64_t p99 = latency_percentile(hist, 0.99);
+	uint64_t p999 = latency_percentile(hist, 0.999);
+	double mean = hist->total ? (double)hist->sum / hist->total : 0.0;
+
+	if (!first_result)
+		printf(",\n");
+	first_result = 0;
+
+	printf("    {\"workload\": \"%s\", \"order\": \"%s\", \"size\": %llu, "
+	       "\"ops\": %llu, \"mean_ns\": %.3f, \"p50_ns\": %llu, "
+	       "\"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu}",
+	       workload, order_names[order], (unsigned long long)size,
+	       (unsigned long long)hist->total, mean, (unsigned long long)p50,
+	       (unsigned long long)p99, (unsigned long long)p999,
+	       (unsigned long long)hist->max);
+	fflush(stdout);
+
+	fprintf(stderr, "%-11s %-10s %10llu %8.1f mean %6llu p50 %6llu p99 "
+		"%6llu p99.9 %8llu max ns\n", workload, order_names[order],
+		(unsigned long long)size, mean, (unsigned long long)p50,
+		(unsigned long long)p99, (unsigned long long)p999,
+		(unsigned long long)hist->max);
+}
+
+/**
+ * fill_order() - Calculate order in which the items are processed
+ * @indices: array to store the item indices
+ * @n: number of items
+ * @order: requested order
+ * @seed: seed for the random permutation
+ */
+static void fill_order(size_t *indices, size_t n, enum order order,
+		       uint64_t seed)
+{
+	size_t i, j, tmp;
+
+	for (i = 0; i < n; i++) {
+		if (order == ORDER_DESCENDING)
+			indices[i] = n - i - 1;
+		else
+			indices[i] = i;
+	}
+
+	if (order != ORDER_RANDOM)
+		return;
+
+	/* Fisher-Yates shuffle */
+	for (i = n; i > 1; i--) {
+		j = (size_t)(bench_mix64(seed + i) % i);
+
+		tmp = indices[i - 1];
+		indices[i - 1] = indices[j];
+		indices[j] = tmp;
+	}
+}
+
+static void latency_insert(struct rb_root *root, struct latency_item *item)
+{
+	RB_LINK *rb_link = &root->node;
+	struct rb_node *parent = NULL;
+	struct rb_node *node;
+	struct latency_item *cur_entry;
+
+	while ((node = rb_link_get(rb_link))) {
+		cur_entry = rb_entry(node, struct latency_item, rb);
+
+		parent = node;
+		if (item->key < cur_entry->key)
+			rb_link = &node->left;
+		else
+			rb_link = &node->right;
+	}
+
+	rb_insert(&item->rb, parent, rb_link, root);
+}
+
+static int latency_cmp(const struct rb_node *node1,
+		       const struct rb_node *node2)
+{
+	const struct latency_item *item1;
+	const struct latency_item *item2;
+
+	item1 = rb_entry(node1, struct latency_item, rb);
+	item2 = rb_entry(node2, struct latency_item, rb);
+
+	if (item1->key < item2->key)
+		return -1;
+
+	return item1->key > item2->key;
+}
+
+static void latency_erase(struct rb_root *root, uint64_t key)
+{
+	struct rb_node *node = rb_link_get(&root->node);
+	struct latency_item *cur_entry;
+
+	while (node) {
+		cur_entry = rb_entry(node, struct latency_item, rb);
+
+		if (key == cur_entry->key) {
+			rb_erase(node, root);
+			return;
+		}
+
+		if (key < cur_entry->key)
+			node = rb_left(node);
+		else
+			node = rb_right(node);
+	}
+
+	/* all keys have to be found */
+	abort();
+}
+
+static void fill_tree(struct rb_root *root, struct latency_item *items,
+		      const size_t *indices, size_t n)
+{
+	size_t i;
+
+	INIT_RB_ROOT(root);
+	for (i = 0; i < n; i++)
+		latency_insert(root, &items[indices[i]]);
+}
+
+static void run_insert(struct latency_hist *hist, struct latency_item *items,
+		       size_t *indices, size_t n, enum order order,
+		       uint64_t seed)
+{
+	struct rb_root root;
+	uint64_t start;
+	size_t i;
+
+	fill_order(indices, n, order, seed);
+
+	INIT_RB_ROOT(&root);
+	for (i = 0; i < n; i++) {
+		start = time_ns();
+		latency_insert(&root, &items[indices[i]]);
+		latency_record(hist, time_ns() - start);
+	}
+}
+
+/**
+ * run_insert_hint() - Insert with the previously inserted node as hint
+ * @hist: histogram for the insert latencies
+ * @items: items which are inserted
+ * @indices: buffer for the order of the items
+ * @n: number of items
+ * @order: order in which the items are inserted
+ * @seed: seed for the random order
+ *
+ * The hint is only correct for ascending and descending order. The random
+ * order therefore shows the cost of a wrong hint in front of the descent.
+ */
+static void run_insert_hint(struct latency_hist *hist,
+			    struct latency_item *items, size_t *indices,
+			    size_t n, enum order order, uint64_t seed)
+{
+	struct rb_node *hint = NULL;
+	struct rb_root root;
+	uint64_t start;
+	size_t i;
+
+	fill_order(indices, n, order, seed);
+
+	INIT_RB_ROOT(&root);
+	for (i = 0; i < n; i++) {
+		start = time_ns();
+		rb_insert_hint(&items[indices[i]].rb, hint, &root,
+			       latency_cmp);
+		latency_record(hist, time_ns() - start);
+
+		hint = &items[indices[i]].rb;
+	}
+}
+
+static void run_erase(struct latency_hist *hist, struct latency_item *items,
+		      size_t *indices, size_t n, enum order order,
+		      uint64_t seed)
+{
+	struct rb_root root;
+	uint64_t start;
+	size_t i;
+
+	fill_order(indices, n, ORDER_RANDOM, seed);
+	fill_tree(&root, items, indices, n);
+
+	fill_order(indices, n, order, seed + 1);
+	for (i = 0; i < n; i++) {
+		start = time_ns();
+		latency_erase(&root, items[indices[i]].key);
+		latency_record(hist, time_ns() - start);
+	}
+
+	if (!rb_empty(&root))
+		abort();
+}
+
+static void run_pop_min(struct latency_hist *hist, struct latency_item *items,
+			size_t *indices, size_t n, enum order order,
+			uint64_t seed)
+{
+	struct rb_node *node;
+	struct rb_root root;
+	uint64_t expected = 0;
+	uint64_t start;
+	uint64_t key;
+
+	/* order only selects the insert order which shapes the tree */
+	fill_order(indices, n, order, seed);
+	fill_tree(&root, items, indices, n);
+
+	while (!rb_empty(&root)) {
+		start = time_ns();
+		node = rb_first(&root);
+		rb_erase(node, &root);
+		latency_record(hist, time_ns() - start);
+
+		key = rb_entry(node, struct latency_item, rb)->key;
+		if (key != expected)
+			abort();
+		expected++;
+	}
+}
+
+static uint64_t timer_overhead(void)
+{
+	struct latency_hist hist = { { 0 }, 0, 0, 0 };
+	uint64_t start;
+	size_t i;
+
+	for (i = 0; i < 100000; i++) {
+		start = time_ns();
+		latency_record(&hist, time_ns() - start);
+	}
+
+	return latency_percentile(&hist, 0.50);
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-n SIZE] [-r ROUNDS]\n", name);
+	fprintf(stderr, "  -n SIZE    number of keys (default 1000000)\n");
+	fprintf(stderr, "  -r ROUNDS  repetitions per workload (default 3)\n");
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct {
+		const char *name;
+		void (*run)(struct latency_hist *hist,
+			    struct latency_item *items, size_t *indices,
+			    size_t n, enum order order, uint64_t seed);
+	} workloads[] = {
+		{ "insert", run_insert },
+		{ "insert-hint", run_insert_hint },
+		{ "erase", run_erase },
+		{ "pop-min", run_pop_min },
+	};
+	struct latency_item *items;
+	struct latency_hist *hist;
+	unsigned long rounds = 3;
+	size_t n = 1000000;
+	unsigned long r;
+	enum order order;
+	size_t *indices;
+	size_t i, w;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:r:h")) != -1) {
+		switch (opt) {
+		case 'n':
+			n = (size_t)strtoull(optarg, NULL, 0);
+			break;
+		case 'r':
+			rounds = strtoul(optarg, NULL, 0);
+			break;
+		case 'h':
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	items = (struct latency_item *)malloc(sizeof(*items) * n);
+	indices = (size_t *)malloc(sizeof(*indices) * n);
+	hist = (struct latency_hist *)malloc(sizeof(*hist));
+	if (!items || !indices || !hist) {
+		fprintf(stderr, "failed to allocate %zu items\n", n);
+		return 1;
+	}
+
+	for (i = 0; i < n; i++)
+		items[i].key = i;
+
+	printf("{\n  \"timer_overhead_ns\": %llu,\n  \"latency\": [\n",
+	       (unsigned long long)timer_overhead());
+
+	for (w = 0; w < sizeof(workloads) / sizeof(workloads[0]); w++) {
+		for (order = ORDER_RANDOM; order < ORDER_COUNT;
+		     order = (enum order)(order + 1)) {
+			memset(hist, 0, sizeof(*hist));
+			for (r = 0; r < rounds; r++)
+				workloads[w].run(hist, items, indices, n, order,
+						 r * n);
+
+			latency_report(hist, workloads[w].name, order, n);
+		}
+	}
+
+	printf("\n  ]\n}\n");
+
+	free(hist);
+	free(indices);
+	free(items);
+
+	return 0;
+}
@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions map benchmark
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory_resource>
+
+#include <unistd.h>
+
+#include "../rbtree-map.hpp"
+#include "bench.h"
+
+namespace {
+
+bool first_result = true;
+
+/**
+ * struct map_result - consistency information of a workload run
+ * @hits: number of found keys
+ * @sum: checksum of the iteration
+ */
+struct map_result {
+	uint64_t hits = 0;
+	uint64_t sum = 0;
+
+	bool operator==(const map_result &other) const
+	{
+		return hits == other.hits && sum == other.sum;
+	}
+};
+
+uint64_t time_ns()
+{
+	auto now = std::chrono::steady_clock::now().time_since_epoch();
+
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+void report(const char *container, const char *resource, const char *workload,
+	    uint64_t size, uint64_t ns)
+{
+	double ns_per_op = (double)ns / (size ? size : 1);
+
+	if (!first_result)
+		std::printf(",\n");
+	first_result = false;
+
+	std::printf("    {\"container\": \"%s\", \"resource\": \"%s\", "
+		    "\"workload\": \"%s\", \"size\": %llu, \"ns_per_op\": %.3f}",
+		    container, resource, workload, (unsigned long long)size,
+		    ns_per_op);
+	std::fflush(stdout);
+
+	std::fprintf(stderr, "%-14s %-10s %-8s %10llu %10.2f ns/op\n", container,
+		     resource, workload, (unsigned long long)size, ns_per_op);
+}
+
+/**
+ * run_map() - Run all workloads for a map
+ * @map: empty map
+ * @container: name of the map implementation
+ * @resource: name of the memory resource
+ * @n: number of keys
+ *
+ * Return: consistency information of the workloads
+ */
+template <class Map>
+map_result run_map(Map &map, const char *container, const char *resource,
+		   uint64_t n)
+{
+	map_result result;
+	uint64_t start;
+	uint64_t i;
+
+	start = time_ns();
+	for (i = 0; i < n; i++)
+		map.try_emplace(bench_mix64(i), i);
+	report(container, resource, "insert", n, time_ns() - start);
+
+	start = time_ns();
+	for (i = 0; i < n; i++) {
+		auto it = map.find(bench_mix64(bench_mix64(i) % n));
+
+		if (it != map.end())
+			result.hits += it->second;
+	}
+	report(container, resource, "lookup", n, time_ns() - start);
+
+	start = time_ns();
+	for (const auto &entry : map)
+		result.sum += entry.first ^ entry.second;
+	report(container, resource, "scan", n, time_ns() - start);
+
+	start = time_ns();
+	for (i = 0; i < n; i++)
+		map.erase(bench_mix64(i));
+	report(container, resource, "erase", n, time_ns() - start);
+
+	if (!map.empty())
+		std::abort();
+
+	return result;
+}
+
+/**
+ * check_result() - Compare workload results with the std::map results
+ * @result: results of the map under test
+ * @expected: results of std::map
+ * @container: name of the map implementation
+ * @resource: name of the memory resource
+ *
+ * Return: true when the results are equal
+ */
+bool check_result(const map_result &result, const map_result &expected,
+		  const char *container, const char *resource)
+{
+	if (result == expected)
+		return true;
+
+	std::fprintf(stderr, "%s (%s) differs from std::map\n", container,
+		     resource);
+	return false;
+}
+
+bool run_size(uint64_t n)
+{
+	map_result expected;
+	bool ok = true;
+
+	{
+		std::map<uint64_t, uint64_t> map;
+
+		expected = run_map(map, "std::map", "new_delete", n);
+	}
+
+	{
+		std::pmr::unsynchronized_pool_resource pool;
+		std::pmr::map<uint64_t, uint64_t> map(&pool);
+
+		ok &= check_result(run_map(map, "std::pmr::map", "pool", n),
+				   expected, "std::pmr::map", "pool");
+	}
+
+	{
+		std::pmr::monotonic_buffer_resource arena;
+		std::pmr::map<uint64_t, uint64_t> map(&arena);
+
+		ok &= check_result(run_map(map, "std::pmr::map", "monotonic", n),
+				   expected, "std::pmr::map", "monotonic");
+	}
+
+	{
+		rb::map<uint64_t, uint64_t> map(std::pmr::new_delete_resource());
+
+		ok &= check_result(run_map(map, "rb::map", "new_delete", n),
+				   expected, "rb::map", "new_delete");
+	}
+
+	{
+		std::pmr::unsynchronized_pool_resource pool;
+		rb::map<uint64_t, uint64_t> map(&pool);
+
+		ok &= check_result(run_map(map, "rb::map", "pool", n),
+				   expected, "rb::map", "pool");
+	}
+
+	{
+		std::pmr::monotonic_buffer_resource arena;
+		rb::map<uint64_t, uint64_t> map(&arena);
+
+		ok &= check_result(run_map(map, "rb::map", "monotonic", n),
+				   expected, "rb::map", "monotonic");
+	}
+
+	return ok;
+}
+
+} /* namespace */
+
+int main(int argc, char *argv[])
+{
+	uint64_t maxsize = 1000000;
+	uint64_t size;
+	int ret = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "m:h")) != -1) {
+		switch (opt) {
+		case 'm':
+			maxsize = std::strtoull(optarg, NULL, 0);
+			break;
+		case 'h':
+		default:
+			std::fprintf(stderr, "Usage: %s [-m MAXSIZE]\n", argv[0]);
+			std::fprintf(stderr, "  -m MAXSIZE  largest number of keys (default 1000000)\n");
+			return 1;
+		}
+	}
+
+	std::printf("{\n  \"benchmarks\": [\n");
+
+	for (size = 1000; size <= maxsize; size *= 10) {
+		if (!run_size(size))
+			ret = 1;
+	}
+
+	std::printf("\n  ]\n}\n");
+
+	return ret;
+}
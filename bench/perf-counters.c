@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions benchmark
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+/* required for syscall */
+#define _GNU_SOURCE
+
+#include "perf-counters.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char *perf_counter_names[PERF_COUNTER_COUNT] = {
+	"instructions",
+	"cache_misses",
+	"dtlb_misses",
+	"branch_misses",
+};
+
+#ifdef __linux__
+/**
+ * struct perf_read_format - result of read for a single counter
+ * @value: counter value
+ * @time_enabled: time in ns the counter was enabled
+ * @time_running: time in ns the counter was scheduled on the PMU
+ */
+struct perf_read_format {
+	uint64_t value;
+	uint64_t time_enabled;
+	uint64_t time_running;
+};
+
+static int perf_counter_open(enum perf_counter_type type)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+			   PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	switch (type) {
+	case PERF_COUNTER_INSTRUCTIONS:
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+		break;
+	case PERF_COUNTER_CACHE_MISSES:
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		break;
+	case PERF_COUNTER_DTLB_MISSES:
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.config = PERF_COUNT_HW_CACHE_DTLB |
+			      (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+			      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		break;
+	case PERF_COUNTER_BRANCH_MISSES:
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+		break;
+	default:
+		return -1;
+	}
+
+	/* measure only this thread on any cpu */
+	return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+/**
+ * perf_counters_open() - Open all available hardware counters
+ * @counters: counters to initialize
+ *
+ * Counters which are not supported by the kernel, the hardware or which are
+ * not allowed by perf_event_paranoid are marked as unavailable.
+ */
+void perf_counters_open(struct perf_counters *counters)
+{
+	size_t i;
+
+	for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+#ifdef __linux__
+		counters->fd[i] = perf_counter_open((enum perf_counter_type)i);
+		if (counters->fd[i] < 0)
+			counters->fd[i] = -1;
+#else
+		counters->fd[i] = -1;
+#endif
+	}
+}
+
+/**
+ * perf_counters_close() - Close all opened hardware counters
+ * @counters: opened counters
+ */
+void perf_counters_close(struct perf_counters *counters)
+{
+	size_t i;
+
+	for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+#ifdef __linux__
+		if (counters->fd[i] >= 0)
+			close(counters->fd[i]);
+#endif
+		counters->fd[i] = -1;
+	}
+}
+
+/**
+ * perf_counters_start() - Reset and start all available counters
+ * @counters: opened counters
+ */
+void perf_counters_start(const struct perf_counters *counters)
+{
+#ifdef __linux__
+	size_t i;
+
+	for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+		if (counters->fd[i] < 0)
+			continue;
+
+		ioctl(counters->fd[i], PERF_EVENT_IOC_RESET, 0);
+		ioctl(counters->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+	}
+#else
+	(void)counters;
+#endif
+}
+
+/**
+ * perf_counters_stop() - Stop all available counters and read them
+ * @counters: opened counters
+ * @values: pointer to the result
+ *
+ * The values are scaled when a counter was not scheduled on the PMU the whole
+ * time because more counters were requested than the hardware provides.
+ */
+void perf_counters_stop(const struct perf_counters *counters,
+			struct perf_values *values)
+{
+	size_t i;
+#ifdef __linux__
+	struct perf_read_format data;
+
+	for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+		if (counters->fd[i] >= 0)
+			ioctl(counters->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+	}
+#endif
+
+	for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+		values->valid[i] = 0;
+		values->value[i] = 0;
+
+#ifdef __linux__
+		if (counters->fd[i] < 0)
+			continue;
+
+		if (read(counters->fd[i], &data, sizeof(data)) != sizeof(data))
+			continue;
+
+		if (!data.time_running)
+			continue;
+
+		values->valid[i] = 1;
+		values->value[i] = data.value;
+		if (data.time_running < data.time_enabled)
+			values->value[i] = (uint64_t)((double)data.value *
+						      data.time_enabled /
+						      data.time_running);
+#endif
+	}
+}
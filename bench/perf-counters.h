@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: MIT */
+/* Minimal red-black-tree helper functions benchmark
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#ifndef __RBTREE_BENCH_PERF_COUNTERS_H__
+#define __RBTREE_BENCH_PERF_COUNTERS_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * enum perf_counter_type - hardware counters collected for each workload
+ * @PERF_COUNTER_INSTRUCTIONS: retired instructions
+ * @PERF_COUNTER_CACHE_MISSES: last level cache misses
+ * @PERF_COUNTER_DTLB_MISSES: data TLB read misses
+ * @PERF_COUNTER_BRANCH_MISSES: mispredicted branches
+ * @PERF_COUNTER_COUNT: number of counter types
+ */
+enum perf_counter_type {
+	PERF_COUNTER_INSTRUCTIONS = 0,
+	PERF_COUNTER_CACHE_MISSES,
+	PERF_COUNTER_DTLB_MISSES,
+	PERF_COUNTER_BRANCH_MISSES,
+	PERF_COUNTER_COUNT
+};
+
+/**
+ * struct perf_counters - opened hardware counters
+ * @fd: perf event file descriptor for each counter. -1 when the counter is
+ *  not available
+ */
+struct perf_counters {
+	int fd[PERF_COUNTER_COUNT];
+};
+
+/**
+ * struct perf_values - measured counter values
+ * @valid: counter was available during the measurement
+ * @value: counter value (scaled when the counter was multiplexed)
+ */
+struct perf_values {
+	int valid[PERF_COUNTER_COUNT];
+	uint64_t value[PERF_COUNTER_COUNT];
+};
+
+extern const char *perf_counter_names[PERF_COUNTER_COUNT];
+
+void perf_counters_open(struct perf_counters *counters);
+void perf_counters_close(struct perf_counters *counters);
+void perf_counters_start(const struct perf_counters *counters);
+void perf_counters_stop(const struct perf_counters *counters,
+			struct perf_values *values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RBTREE_BENCH_PERF_COUNTERS_H__ */
@@ -0,0 +1,294 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions trace replay benchmark
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+/* required for clock_gettime and getopt */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "trace.h"
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+
+static const struct bench_engine *engines[] = {
+	&bench_engine_rbtree,
+	&bench_engine_stdset,
+	&bench_engine_btree,
+};
+
+/**
+ * struct replay_result - consistency information of a replayed trace
+ * @hits: number of successful operations for each operation type
+ * @sum: sum of all checksums of the iterations
+ */
+struct replay_result {
+	uint64_t hits[TRACE_OP_COUNT];
+	uint64_t sum;
+};
+
+static uint64_t time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+/**
+ * replay() - Run all events of a trace against a new set
+ * @engine: set implementation
+ * @events: decoded trace
+ * @count: number of events in @events
+ * @result: consistency information of the run
+ *
+ * Return: time in ns to run all events
+ */
+static uint64_t replay(const struct bench_engine *engine,
+		       const struct trace_event *events, size_t count,
+		       struct replay_result *result)
+{
+	uint64_t start;
+	uint64_t ns;
+	uint64_t key;
+	uint64_t sum;
+	void *set;
+	size_t i;
+
+	memset(result, 0, sizeof(*result));
+	set = engine->create();
+	if (!set)
+		abort();
+
+	start = time_ns();
+	for (i = 0; i < count; i++) {
+		key = events[i].key;
+
+		switch (events[i].op) {
+		case TRACE_OP_INSERT:
+			result->hits[TRACE_OP_INSERT] += engine->insert(set, key);
+			break;
+		case TRACE_OP_ERASE:
+			result->hits[TRACE_OP_ERASE] += engine->erase(set, key);
+			break;
+		case TRACE_OP_FIND:
+			result->hits[TRACE_OP_FIND] += engine->find(set, key);
+			break;
+		case TRACE_OP_ITERATE:
+		default:
+			sum = engine->scan(set);
+			result->hits[TRACE_OP_ITERATE]++;
+			result->sum += sum;
+			break;
+		}
+	}
+	ns = time_ns() - start;
+
+	engine->destroy(set);
+
+	return ns;
+}
+
+/**
+ * generate() - Record synthetic trace
+ * @path: path of the new trace file
+ * @count: number of events in the trace
+ *
+ * The trace is a mix of 40% finds, 30% inserts and 30% erases of random keys
+ * with a full iteration after every 100000 events. It is recorded through the
+ * recorder shim next to the calls of the rbtree engine.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+static int generate(const char *path, uint64_t count)
+{
+	const struct bench_engine *engine = &bench_engine_rbtree;
+	struct trace_recorder recorder;
+	uint64_t keys = count / 4 + 1;
+	uint64_t key;
+	uint64_t i;
+	void *set;
+	int ret;
+
+	ret = trace_recorder_open(&recorder, path);
+	if (ret < 0)
+		return ret;
+
+	set = engine->create();
+	if (!set)
+		abort();
+
+	for (i = 0; i < count; i++) {
+		key = bench_mix64(bench_mix64(i) % keys);
+
+		if (i % 100000 == 99999) {
+			trace_record(&recorder, TRACE_OP_ITERATE, 0);
+			engine->scan(set);
+			continue;
+		}
+
+		switch (i % 10) {
+		case 0:
+		case 3:
+		case 6:
+			trace_record(&recorder, TRACE_OP_INSERT, key);
+			engine->insert(set, key);
+			break;
+		case 1:
+		case 5:
+		case 8:
+			trace_record(&recorder, TRACE_OP_ERASE, key);
+			engine->erase(set, key);
+			break;
+		default:
+			trace_record(&recorder, TRACE_OP_FIND, key);
+			engine->find(set, key);
+			break;
+		}
+	}
+
+	engine->destroy(set);
+
+	return trace_recorder_close(&recorder);
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-e ENGINE] [-r ROUNDS] TRACE\n", name);
+	fprintf(stderr, "       %s -g COUNT TRACE\n", name);
+	fprintf(stderr, "  -e ENGINE   only run selected engine (rbtree, std::set, btree)\n");
+	fprintf(stderr, "  -r ROUNDS   repetitions of the trace (default 5)\n");
+	fprintf(stderr, "  -g COUNT    record synthetic trace with COUNT events\n");
+}
+
+int main(int argc, char *argv[])
+{
+	struct replay_result results[ARRAY_SIZE(engines)];
+	struct replay_result result;
+	const char *engine_filter = NULL;
+	uint64_t op_count[TRACE_OP_COUNT];
+	struct trace_event *events;
+	unsigned long rounds = 5;
+	uint64_t generate_count = 0;
+	int first_result = 1;
+	uint64_t ns, best, total;
+	const char *path;
+	unsigned long r;
+	size_t count;
+	size_t i, j;
+	int ret = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "e:r:g:h")) != -1) {
+		switch (opt) {
+		case 'e':
+			engine_filter = optarg;
+			break;
+		case 'r':
+			rounds = strtoul(optarg, NULL, 0);
+			break;
+		case 'g':
+			generate_count = strtoull(optarg, NULL, 0);
+			break;
+		case 'h':
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (optind + 1 != argc || rounds == 0) {
+		usage(argv[0]);
+		return 1;
+	}
+	path = argv[optind];
+
+	if (generate_count) {
+		ret = generate(path, generate_count);
+		if (ret < 0) {
+			fprintf(stderr, "failed to record %s: %s\n", path,
+				strerror(-ret));
+			return 1;
+		}
+
+		return 0;
+	}
+
+	ret = trace_load(path, &events, &count);
+	if (ret < 0) {
+		fprintf(stderr, "failed to load %s: %s\n", path, strerror(-ret));
+		return 1;
+	}
+
+	memset(op_count, 0, sizeof(op_count));
+	for (i = 0; i < count; i++)
+		op_count[events[i].op]++;
+
+	printf("{\n  \"trace\": \"%s\",\n  \"events\": %llu,\n", path,
+	       (unsigned long long)count);
+	for (i = 0; i < TRACE_OP_COUNT; i++)
+		printf("  \"%s\": %llu,\n", trace_op_names[i],
+		       (unsigned long long)op_count[i]);
+	printf("  \"replays\": [\n");
+
+	for (i = 0; i < ARRAY_SIZE(engines); i++) {
+		if (engine_filter && strcmp(engine_filter, engines[i]->name) != 0)
+			continue;
+
+		best = UINT64_MAX;
+		total = 0;
+		for (r = 0; r < rounds; r++) {
+			ns = replay(engines[i], events, count, &result);
+			total += ns;
+			if (ns < best)
+				best = ns;
+		}
+		results[i] = result;
+
+		if (!first_result)
+			printf(",\n");
+		first_result = 0;
+
+		printf("    {\"engine\": \"%s\", \"rounds\": %lu, "
+		       "\"ns_per_op_min\": %.3f, \"ns_per_op_mean\": %.3f",
+		       engines[i]->name, rounds, (double)best / (count ? count : 1),
+		       (double)total / rounds / (count ? count : 1));
+		for (j = 0; j < TRACE_OP_COUNT; j++)
+			printf(", \"%s_hits\": %llu", trace_op_names[j],
+			       (unsigned long long)result.hits[j]);
+		printf("}");
+		fflush(stdout);
+
+		fprintf(stderr,
+			"%-10s %10llu events %10.2f ns/op (min) %10.2f ns/op (mean)\n",
+			engines[i]->name, (unsigned long long)count,
+			(double)best / (count ? count : 1),
+			(double)total / rounds / (count ? count : 1));
+	}
+
+	printf("\n  ]\n}\n");
+
+	/* all engines must have seen the same set content */
+	for (i = 1; !engine_filter && i < ARRAY_SIZE(engines); i++) {
+		if (memcmp(&results[i], &results[0], sizeof(results[0])) == 0)
+			continue;
+
+		fprintf(stderr, "%s differs from %s\n", engines[i]->name,
+			engines[0]->name);
+		ret = 1;
+	}
+
+	free(events);
+
+	return ret;
+}
@@ -0,0 +1,240 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions benchmark
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include "trace.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char *trace_op_names[TRACE_OP_COUNT] = {
+	"insert",
+	"erase",
+	"find",
+	"iterate",
+};
+
+static void trace_put_u32(unsigned char *buf, uint32_t value)
+{
+	buf[0] = (unsigned char)(value & 0xff);
+	buf[1] = (unsigned char)((value >> 8) & 0xff);
+	buf[2] = (unsigned char)((value >> 16) & 0xff);
+	buf[3] = (unsigned char)((value >> 24) & 0xff);
+}
+
+static uint32_t trace_get_u32(const unsigned char *buf)
+{
+	return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+	       ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+/**
+ * trace_recorder_open() - Create trace file and write header
+ * @recorder: recorder to initialize
+ * @path: path of the new trace file
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+int trace_recorder_open(struct trace_recorder *recorder, const char *path)
+{
+	unsigned char header[TRACE_MAGIC_LEN + 4];
+
+	memset(header, 0, sizeof(header));
+	memcpy(header, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+	trace_put_u32(&header[TRACE_MAGIC_LEN], TRACE_VERSION);
+
+	recorder->prev_key = 0;
+	recorder->error = 0;
+	recorder->file = fopen(path, "wb");
+	if (!recorder->file)
+		return -errno;
+
+	if (fwrite(header, sizeof(header), 1, recorder->file) != 1)
+		recorder->error = 1;
+
+	return 0;
+}
+
+/**
+ * trace_record() - Append operation to trace
+ * @recorder: open recorder
+ * @op: operation to record
+ * @key: key of the operation (ignored for TRACE_OP_ITERATE)
+ *
+ * Write errors are reported by trace_recorder_close.
+ */
+void trace_record(struct trace_recorder *recorder, enum trace_op op,
+		  uint64_t key)
+{
+	unsigned char buf[1 + 10];
+	uint64_t delta;
+	size_t len = 0;
+
+	buf[len++] = (unsigned char)op;
+
+	if (op != TRACE_OP_ITERATE) {
+		/* zigzag encoding of the signed difference */
+		delta = key - recorder->prev_key;
+		delta = (delta << 1) ^ (0 - (delta >> 63));
+		recorder->prev_key = key;
+
+		do {
+			buf[len] = (unsigned char)(delta & 0x7f);
+			delta >>= 7;
+			if (delta)
+				buf[len] |= 0x80;
+			len++;
+		} while (delta);
+	}
+
+	if (fwrite(buf, len, 1, recorder->file) != 1)
+		recorder->error = 1;
+}
+
+/**
+ * trace_recorder_close() - Flush and close trace file
+ * @recorder: open recorder
+ *
+ * Return: 0 on success, -EIO when any record could not be written
+ */
+int trace_recorder_close(struct trace_recorder *recorder)
+{
+	if (fclose(recorder->file) != 0)
+		recorder->error = 1;
+	recorder->file = NULL;
+
+	return recorder->error ? -EIO : 0;
+}
+
+/**
+ * trace_decode() - Decode records of a trace file
+ * @buf: content of the trace file after the header
+ * @len: length of @buf
+ * @events: array to store the decoded events, NULL to only count them
+ *
+ * Return: number of events, -EINVAL when @buf contains an invalid record
+ */
+static long trace_decode(const unsigned char *buf, size_t len,
+			 struct trace_event *events)
+{
+	uint64_t prev_key = 0;
+	uint64_t delta;
+	unsigned int shift;
+	unsigned char op;
+	size_t pos = 0;
+	long count = 0;
+
+	while (pos < len) {
+		op = buf[pos++];
+		if (op >= TRACE_OP_COUNT)
+			return -EINVAL;
+
+		delta = 0;
+		if (op != TRACE_OP_ITERATE) {
+			shift = 0;
+			do {
+				if (pos >= len || shift > 63)
+					return -EINVAL;
+
+				delta |= (uint64_t)(buf[pos] & 0x7f) << shift;
+				shift += 7;
+			} while (buf[pos++] & 0x80);
+
+			delta = (delta >> 1) ^ (0 - (delta & 1));
+			prev_key += delta;
+		}
+
+		if (events) {
+			events[count].op = (enum trace_op)op;
+			events[count].key = op == TRACE_OP_ITERATE ? 0 : prev_key;
+		}
+		count++;
+	}
+
+	return count;
+}
+
+/**
+ * trace_load() - Read and decode complete trace file
+ * @path: path of the trace file
+ * @events: pointer to store the allocated array of events
+ * @count: pointer to store the number of events
+ *
+ * The array has to be freed by the caller.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+int trace_load(const char *path, struct trace_event **events, size_t *count)
+{
+	unsigned char header[TRACE_MAGIC_LEN + 4];
+	unsigned char *buf = NULL;
+	size_t len = 0;
+	size_t size = 0;
+	unsigned char *tmp;
+	long decoded;
+	FILE *file;
+	size_t ret;
+	int err = 0;
+
+	*events = NULL;
+	*count = 0;
+
+	file = fopen(path, "rb");
+	if (!file)
+		return -errno;
+
+	if (fread(header, sizeof(header), 1, file) != 1 ||
+	    memcmp(header, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+	    trace_get_u32(&header[TRACE_MAGIC_LEN]) != TRACE_VERSION) {
+		err = -EINVAL;
+		goto out;
+	}
+
+	do {
+		if (len == size) {
+			size = size ? size * 2 : 65536;
+			tmp = (unsigned char *)realloc(buf, size);
+			if (!tmp) {
+				err = -ENOMEM;
+				goto out;
+			}
+			buf = tmp;
+		}
+
+		ret = fread(&buf[len], 1, size - len, file);
+		len += ret;
+	} while (ret);
+
+	if (ferror(file)) {
+		err = -EIO;
+		goto out;
+	}
+
+	decoded = trace_decode(buf, len, NULL);
+	if (decoded < 0) {
+		err = (int)decoded;
+		goto out;
+	}
+
+	*events = (struct trace_event *)malloc(sizeof(**events) *
+					       (decoded ? decoded : 1));
+	if (!*events) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	trace_decode(buf, len, *events);
+	*count = (size_t)decoded;
+
+out:
+	free(buf);
+	fclose(file);
+
+	return err;
+}
@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: MIT */
+/* Minimal red-black-tree helper functions benchmark
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#ifndef __RBTREE_BENCH_TRACE_H__
+#define __RBTREE_BENCH_TRACE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* trace file starts with TRACE_MAGIC followed by 4 byte TRACE_VERSION */
+#define TRACE_MAGIC "RBTRACE"
+#define TRACE_MAGIC_LEN 8
+#define TRACE_VERSION 1
+
+/**
+ * enum trace_op - recorded operation
+ * @TRACE_OP_INSERT: insert key (duplicates are ignored)
+ * @TRACE_OP_ERASE: erase key (missing keys are ignored)
+ * @TRACE_OP_FIND: search key
+ * @TRACE_OP_ITERATE: iterate over all entries in order (no key)
+ * @TRACE_OP_COUNT: number of operation types
+ *
+ * Each record is stored as single byte with the operation. The keyed
+ * operations are followed by the difference to the previous recorded key. It
+ * is zigzag encoded and stored as unsigned LEB128. Sequential keys therefore
+ * only need two bytes per record.
+ */
+enum trace_op {
+	TRACE_OP_INSERT = 0,
+	TRACE_OP_ERASE,
+	TRACE_OP_FIND,
+	TRACE_OP_ITERATE,
+	TRACE_OP_COUNT
+};
+
+/**
+ * struct trace_event - decoded record of a trace
+ * @op: recorded operation
+ * @key: key of the operation (0 for TRACE_OP_ITERATE)
+ */
+struct trace_event {
+	enum trace_op op;
+	uint64_t key;
+};
+
+/**
+ * struct trace_recorder - open trace file for writing
+ * @file: output file
+ * @prev_key: last recorded key
+ * @error: write to @file failed
+ */
+struct trace_recorder {
+	FILE *file;
+	uint64_t prev_key;
+	int error;
+};
+
+extern const char *trace_op_names[TRACE_OP_COUNT];
+
+int trace_recorder_open(struct trace_recorder *recorder, const char *path);
+void trace_record(struct trace_recorder *recorder, enum trace_op op,
+		  uint64_t key);
+int trace_recorder_close(struct trace_recorder *recorder);
+
+int trace_load(const char *path, struct trace_event **events, size_t *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RBTREE_BENCH_TRACE_H__ */
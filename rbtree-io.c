@@ -0,0 +1,385 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions - serialization
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#ifndef _POSIX_C_SOURCE
+/* required for posix_memalign */
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "rbtree-io.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* alignment of buffers, file offsets and write sizes (for O_DIRECT) */
+#define RB_IO_ALIGN 4096
+
+/* minimal size of the buffer for a single read or write */
+#define RB_IO_BUFFER_SIZE (1024 * 1024)
+
+#define RB_IO_MAGIC "RBTREEIO"
+#define RB_IO_MAGIC_SIZE 8
+#define RB_IO_VERSION 1
+#define RB_IO_HEADER_SIZE 16
+#define RB_IO_FRAME_HEADER_SIZE 4
+
+/**
+ * struct rb_io_buffer - aligned buffer for a file stream
+ * @fd: file descriptor of the stream
+ * @buf: buffer with RB_IO_ALIGN alignment
+ * @size: size of @buf, multiple of RB_IO_ALIGN
+ * @start: first unconsumed byte (only load)
+ * @used: end of valid data in @buf
+ * @eof: no more data can be read from @fd (only load)
+ */
+struct rb_io_buffer {
+	int fd;
+	unsigned char *buf;
+	size_t size;
+	size_t start;
+	size_t used;
+	int eof;
+};
+
+static void rb_io_put_u32(unsigned char *buf, uint32_t value)
+{
+	buf[0] = (unsigned char)(value & 0xff);
+	buf[1] = (unsigned char)((value >> 8) & 0xff);
+	buf[2] = (unsigned char)((value >> 16) & 0xff);
+	buf[3] = (unsigned char)((value >> 24) & 0xff);
+}
+
+static uint32_t rb_io_get_u32(const unsigned char *buf)
+{
+	return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+	       ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+static size_t rb_io_align(size_t size)
+{
+	return (size + RB_IO_ALIGN - 1) / RB_IO_ALIGN * RB_IO_ALIGN;
+}
+
+/**
+ * rb_io_buffer_init() - Allocate aligned buffer
+ * @io: buffer to initialize
+ * @fd: file descriptor of the stream
+ * @record_size: size of a single record
+ *
+ * Return: 0 on success, -ENOMEM when the buffer could not be allocated
+ */
+static int rb_io_buffer_init(struct rb_io_buffer *io, int fd,
+			     size_t record_size)
+{
+	void *buf;
+
+	memset(io, 0, sizeof(*io));
+	io->fd = fd;
+
+	/* a full frame must fit after the unaligned tail of the last write */
+	io->size = rb_io_align(RB_IO_ALIGN + RB_IO_HEADER_SIZE +
+			       2 * RB_IO_FRAME_HEADER_SIZE + record_size);
+	if (io->size < RB_IO_BUFFER_SIZE)
+		io->size = RB_IO_BUFFER_SIZE;
+
+	if (posix_memalign(&buf, RB_IO_ALIGN, io->size))
+		return -ENOMEM;
+
+	io->buf = (unsigned char *)buf;
+
+	return 0;
+}
+
+/**
+ * rb_io_flush() - Write aligned part of the buffer
+ * @io: buffer with data to write
+ * @final: pad and write all data
+ *
+ * Only multiples of RB_IO_ALIGN are written. The remaining bytes are moved to
+ * the beginning of the buffer. The final write is padded with zeros.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+static int rb_io_flush(struct rb_io_buffer *io, int final)
+{
+	size_t len = io->used / RB_IO_ALIGN * RB_IO_ALIGN;
+	size_t pos = 0;
+	ssize_t ret;
+
+	if (final) {
+		len = rb_io_align(io->used);
+		memset(&io->buf[io->used], 0, len - io->used);
+		io->used = len;
+	}
+
+	while (pos < len) {
+		ret = write(io->fd, &io->buf[pos], len - pos);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0)
+			return -errno;
+		if (ret == 0)
+			return -EIO;
+
+		pos += (size_t)ret;
+	}
+
+	memmove(io->buf, &io->buf[len], io->used - len);
+	io->used -= len;
+
+	return 0;
+}
+
+/**
+ * rb_save() - Write all nodes of tree in order to file
+ * @fd: file descriptor opened for writing
+ * @root: pointer to rb root
+ * @record_size: size of each encoded node in bytes
+ * @encode: function which writes @record_size bytes for a node to @record
+ * @arg: argument for @encode
+ *
+ * The nodes are retrieved via rb_first/rb_next and are encoded directly into
+ * an aligned buffer of at least RB_IO_BUFFER_SIZE bytes. The file starts
+ * with a header (magic, version, @record_size) and is followed by frames with
+ * a record count and the records of the frame. A frame with zero records
+ * marks the end of the stream.
+ *
+ * All writes are aligned to RB_IO_ALIGN bytes and the file is padded with
+ * zeros to a multiple of RB_IO_ALIGN. @fd can therefore be opened with
+ * O_DIRECT.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+int rb_save(int fd, const struct rb_root *root, size_t record_size,
+	    void (*encode)(const struct rb_node *node, void *record,
+			   void *arg),
+	    void *arg)
+{
+	struct rb_io_buffer io;
+	struct rb_node *node;
+	size_t frame_records;
+	size_t frame;
+	uint32_t count;
+	int ret;
+
+	if (!record_size || record_size > UINT32_MAX)
+		return -EINVAL;
+
+	ret = rb_io_buffer_init(&io, fd, record_size);
+	if (ret < 0)
+		return ret;
+
+	memcpy(io.buf, RB_IO_MAGIC, RB_IO_MAGIC_SIZE);
+	rb_io_put_u32(&io.buf[8], RB_IO_VERSION);
+	rb_io_put_u32(&io.buf[12], (uint32_t)record_size);
+	io.used = RB_IO_HEADER_SIZE;
+
+	/* frames are filled until the buffer is full */
+	node = rb_first(root);
+	while (node) {
+		/* space for frame header and end marker is kept free */
+		if (io.size - io.used <
+		    2 * RB_IO_FRAME_HEADER_SIZE + record_size) {
+			ret = rb_io_flush(&io, 0);
+			if (ret < 0)
+				goto out;
+
+			continue;
+		}
+
+		frame_records = io.size - io.used - 2 * RB_IO_FRAME_HEADER_SIZE;
+		frame_records /= record_size;
+
+		frame = io.used;
+		io.used += RB_IO_FRAME_HEADER_SIZE;
+
+		for (count = 0; node && count < frame_records; count++) {
+			encode(node, &io.buf[io.used], arg);
+			io.used += record_size;
+			node = rb_next(node);
+		}
+
+		rb_io_put_u32(&io.buf[frame], count);
+	}
+
+	rb_io_put_u32(&io.buf[io.used], 0);
+	io.used += RB_IO_FRAME_HEADER_SIZE;
+
+	ret = rb_io_flush(&io, 1);
+
+out:
+	free(io.buf);
+
+	return ret;
+}
+
+/**
+ * rb_io_fill() - Make sure that enough data is available in buffer
+ * @io: buffer to fill
+ * @len: number of bytes which have to be available after @io->start
+ *
+ * The unconsumed bytes are moved in front of an aligned offset. New data is
+ * then read with aligned sizes to this offset.
+ *
+ * Return: 0 on success, -EINVAL when the stream ended early, negative errno
+ *  on read errors
+ */
+static int rb_io_fill(struct rb_io_buffer *io, size_t len)
+{
+	size_t avail = io->used - io->start;
+	size_t offset;
+	ssize_t ret;
+
+	if (avail >= len)
+		return 0;
+
+	offset = rb_io_align(avail) - avail;
+	memmove(&io->buf[offset], &io->buf[io->start], avail);
+	io->start = offset;
+	io->used = offset + avail;
+
+	while (io->used - io->start < len) {
+		if (io->eof)
+			return -EINVAL;
+
+		ret = read(io->fd, &io->buf[io->used], io->size - io->used);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0)
+			return -errno;
+
+		if (ret == 0)
+			io->eof = 1;
+
+		io->used += (size_t)ret;
+	}
+
+	return 0;
+}
+
+/**
+ * rb_io_reserve() - Make sure that node array has space for another node
+ * @nodes: pointer to the array of nodes
+ * @count: number of nodes in @nodes
+ * @capacity: pointer to the number of allocated entries in @nodes
+ *
+ * Return: 0 on success, -ENOMEM when the array could not be resized
+ */
+static int rb_io_reserve(struct rb_node ***nodes, size_t count,
+			 size_t *capacity)
+{
+	struct rb_node **resized;
+	size_t new_capacity;
+
+	if (count < *capacity)
+		return 0;
+
+	new_capacity = *capacity ? *capacity * 2 : 1024;
+	resized = (struct rb_node **)realloc(*nodes, sizeof(**nodes) *
+					     new_capacity);
+	if (!resized)
+		return -ENOMEM;
+
+	*nodes = resized;
+	*capacity = new_capacity;
+
+	return 0;
+}
+
+/**
+ * rb_load() - Read tree from file created by rb_save
+ * @fd: file descriptor opened for reading
+ * @root: pointer to rb root which is replaced by the loaded tree
+ * @record_size: size of each encoded node in bytes
+ * @decode: function which returns a new node for a record, NULL on errors
+ * @arg: argument for @decode
+ *
+ * The records are read with large aligned reads and are already sorted. The
+ * tree is therefore built via rb_build in O(n) without any comparison. @fd
+ * can be opened with O_DIRECT.
+ *
+ * @root contains all successfully decoded nodes when an error occurs while
+ * reading the records. The caller can free them like for any other tree.
+ *
+ * Return: 0 on success, -EINVAL for an invalid or truncated file, -ENOMEM
+ *  when @decode failed or memory could not be allocated, negative errno on
+ *  read errors
+ */
+int rb_load(int fd, struct rb_root *root, size_t record_size,
+	    struct rb_node *(*decode)(const void *record, void *arg),
+	    void *arg)
+{
+	struct rb_node **nodes = NULL;
+	struct rb_io_buffer io;
+	struct rb_node *node;
+	size_t capacity = 0;
+	size_t count = 0;
+	uint32_t frame;
+	int ret;
+
+	INIT_RB_ROOT(root);
+
+	if (!record_size || record_size > UINT32_MAX)
+		return -EINVAL;
+
+	ret = rb_io_buffer_init(&io, fd, record_size);
+	if (ret < 0)
+		return ret;
+
+	ret = rb_io_fill(&io, RB_IO_HEADER_SIZE);
+	if (ret < 0)
+		goto free_buf;
+
+	if (memcmp(io.buf, RB_IO_MAGIC, RB_IO_MAGIC_SIZE) != 0 ||
+	    rb_io_get_u32(&io.buf[8]) != RB_IO_VERSION ||
+	    rb_io_get_u32(&io.buf[12]) != record_size) {
+		ret = -EINVAL;
+		goto free_buf;
+	}
+	io.start = RB_IO_HEADER_SIZE;
+
+	for (;;) {
+		ret = rb_io_fill(&io, RB_IO_FRAME_HEADER_SIZE);
+		if (ret < 0)
+			goto build;
+
+		frame = rb_io_get_u32(&io.buf[io.start]);
+		io.start += RB_IO_FRAME_HEADER_SIZE;
+		if (!frame)
+			break;
+
+		for (; frame > 0; frame--) {
+			ret = rb_io_fill(&io, record_size);
+			if (ret < 0)
+				goto build;
+
+			ret = rb_io_reserve(&nodes, count, &capacity);
+			if (ret < 0)
+				goto build;
+
+			node = decode(&io.buf[io.start], arg);
+			if (!node) {
+				ret = -ENOMEM;
+				goto build;
+			}
+
+			nodes[count++] = node;
+			io.start += record_size;
+		}
+	}
+
+build:
+	rb_build(root, nodes, count);
+	free(nodes);
+free_buf:
+	free(io.buf);
+
+	return ret;
+}
@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: MIT */
+/* Minimal red-black-tree helper functions - serialization
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#ifndef __RBTREE_IO_H__
+#define __RBTREE_IO_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "rbtree.h"
+
+int rb_save(int fd, const struct rb_root *root, size_t record_size,
+	    void (*encode)(const struct rb_node *node, void *record,
+			   void *arg),
+	    void *arg);
+int rb_load(int fd, struct rb_root *root, size_t record_size,
+	    struct rb_node *(*decode)(const void *record, void *arg),
+	    void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RBTREE_IO_H__ */
@@ -0,0 +1,744 @@
+/* SPDX-License-Identifier: MIT */
+/* Minimal red-black-tree helper functions - C++17 ordered map
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#ifndef __RBTREE_MAP_HPP__
+#define __RBTREE_MAP_HPP__
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "rbtree.h"
+
+namespace rb {
+
+/**
+ * class map - ordered map with nodes from a polymorphic memory resource
+ * @K: type of the keys
+ * @V: type of the mapped values (can be move-only)
+ * @Compare: strict weak ordering of @K
+ *
+ * Each entry is a single allocation from the memory resource of the map. It
+ * contains the rb node, the key and the value. Entries are never copied or
+ * moved in memory. References and iterators therefore stay valid until the
+ * entry is erased or extracted.
+ *
+ * The memory resource must outlive the map and all node handles extracted
+ * from it.
+ */
+template <class K, class V, class Compare = std::less<K>>
+class map {
+public:
+	using key_type = K;
+	using mapped_type = V;
+	using value_type = std::pair<const K, V>;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using key_compare = Compare;
+	using reference = value_type &;
+	using const_reference = const value_type &;
+	using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+
+private:
+	struct node : rb_node {
+		template <class... Args>
+		explicit node(Args &&...args)
+			: rb_node(), value(std::forward<Args>(args)...)
+		{
+		}
+
+		value_type value;
+	};
+
+	static node *to_node(rb_node *rbnode)
+	{
+		return static_cast<node *>(rbnode);
+	}
+
+	static const node *to_node(const rb_node *rbnode)
+	{
+		return static_cast<const node *>(rbnode);
+	}
+
+	template <bool Const>
+	class iterator_base {
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = map::value_type;
+		using difference_type = std::ptrdiff_t;
+		using pointer = std::conditional_t<Const, const value_type *,
+						   value_type *>;
+		using reference = std::conditional_t<Const, const value_type &,
+						     value_type &>;
+
+		iterator_base() = default;
+
+		/* allow conversion from iterator to const_iterator */
+		template <bool OtherConst,
+			  class = std::enable_if_t<Const && !OtherConst>>
+		iterator_base(const iterator_base<OtherConst> &other)
+			: node_(other.node_), root_(other.root_)
+		{
+		}
+
+		reference operator*() const
+		{
+			return to_node(node_)->value;
+		}
+
+		pointer operator->() const
+		{
+			return &to_node(node_)->value;
+		}
+
+		iterator_base &operator++()
+		{
+			node_ = rb_next(node_);
+			return *this;
+		}
+
+		iterator_base operator++(int)
+		{
+			iterator_base old(*this);
+
+			node_ = rb_next(node_);
+			return old;
+		}
+
+		iterator_base &operator--()
+		{
+			if (node_)
+				node_ = rb_prev(node_);
+			else
+				node_ = rb_last(root_);
+			return *this;
+		}
+
+		iterator_base operator--(int)
+		{
+			iterator_base old(*this);
+
+			--*this;
+			return old;
+		}
+
+		friend bool operator==(const iterator_base &a,
+				       const iterator_base &b)
+		{
+			return a.node_ == b.node_;
+		}
+
+		friend bool operator!=(const iterator_base &a,
+				       const iterator_base &b)
+		{
+			return a.node_ != b.node_;
+		}
+
+	private:
+		friend class map;
+		template <bool> friend class iterator_base;
+
+		iterator_base(rb_node *node, const rb_root *root)
+			: node_(node), root_(root)
+		{
+		}
+
+		rb_node *node_ = nullptr;
+		const rb_root *root_ = nullptr;
+	};
+
+public:
+	using iterator = iterator_base<false>;
+	using const_iterator = iterator_base<true>;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	/**
+	 * class node_type - handle owning an extracted entry
+	 *
+	 * The entry is destroyed and returned to the memory resource when the
+	 * handle is destroyed without being inserted into a map again.
+	 */
+	class node_type {
+	public:
+		using key_type = map::key_type;
+		using mapped_type = map::mapped_type;
+		using allocator_type = map::allocator_type;
+
+		node_type() = default;
+
+		node_type(node_type &&other) noexcept
+			: node_(std::exchange(other.node_, nullptr)),
+			  mr_(other.mr_)
+		{
+		}
+
+		node_type &operator=(node_type &&other) noexcept
+		{
+			reset();
+			node_ = std::exchange(other.node_, nullptr);
+			mr_ = other.mr_;
+			return *this;
+		}
+
+		~node_type()
+		{
+			reset();
+		}
+
+		bool empty() const noexcept
+		{
+			return !node_;
+		}
+
+		explicit operator bool() const noexcept
+		{
+			return node_;
+		}
+
+		/* the key may be modified while the entry is not in a map */
+		key_type &key() const
+		{
+			return const_cast<key_type &>(node_->value.first);
+		}
+
+		mapped_type &mapped() const
+		{
+			return node_->value.second;
+		}
+
+		allocator_type get_allocator() const
+		{
+			return allocator_type(mr_);
+		}
+
+	private:
+		friend class map;
+
+		node_type(node *n, std::pmr::memory_resource *mr)
+			: node_(n), mr_(mr)
+		{
+		}
+
+		node *release()
+		{
+			return std::exchange(node_, nullptr);
+		}
+
+		void reset()
+		{
+			if (node_)
+				map::destroy_node(node_, mr_);
+			node_ = nullptr;
+		}
+
+		node *node_ = nullptr;
+		std::pmr::memory_resource *mr_ = nullptr;
+	};
+
+	/**
+	 * struct insert_return_type - result of inserting a node handle
+	 * @position: iterator to the inserted or the blocking entry
+	 * @inserted: node handle was inserted
+	 * @node: node handle when it was not inserted
+	 */
+	struct insert_return_type {
+		iterator position;
+		bool inserted;
+		node_type node;
+	};
+
+	map() : map(std::pmr::get_default_resource())
+	{
+	}
+
+	explicit map(std::pmr::memory_resource *mr,
+		     const Compare &comp = Compare())
+		: mr_(mr), comp_(comp)
+	{
+		INIT_RB_ROOT(&root_);
+	}
+
+	map(const map &) = delete;
+	map &operator=(const map &) = delete;
+
+	/* entries are taken over - both maps then share the memory resource */
+	map(map &&other) noexcept
+		: mr_(other.mr_), comp_(std::move(other.comp_)),
+		  size_(std::exchange(other.size_, 0))
+	{
+		rb_link_set(&root_.node, rb_link_get(&other.root_.node));
+		INIT_RB_ROOT(&other.root_);
+	}
+
+	map &operator=(map &&other)
+	{
+		if (this == &other)
+			return *this;
+
+		/* entries of other are ordered by its comparator */
+		clear();
+		comp_ = std::move(other.comp_);
+		if (mr_ == other.mr_ || *mr_ == *other.mr_) {
+			rb_link_set(&root_.node,
+				    rb_link_get(&other.root_.node));
+			size_ = std::exchange(other.size_, 0);
+			INIT_RB_ROOT(&other.root_);
+			return *this;
+		}
+
+		/* different resources - entries have to be reallocated. The key
+		 * is const in the entry and can therefore only be copied
+		 */
+		for (auto &value : other)
+			try_emplace(value.first, std::move(value.second));
+		other.clear();
+
+		return *this;
+	}
+
+	~map()
+	{
+		clear();
+	}
+
+	allocator_type get_allocator() const noexcept
+	{
+		return allocator_type(mr_);
+	}
+
+	bool empty() const noexcept
+	{
+		return rb_empty(&root_);
+	}
+
+	size_type size() const noexcept
+	{
+		return size_;
+	}
+
+	iterator begin() noexcept
+	{
+		return iterator(rb_first(&root_), &root_);
+	}
+
+	const_iterator begin() const noexcept
+	{
+		return const_iterator(rb_first(&root_), &root_);
+	}
+
+	iterator end() noexcept
+	{
+		return iterator(nullptr, &root_);
+	}
+
+	const_iterator end() const noexcept
+	{
+		return const_iterator(nullptr, &root_);
+	}
+
+	reverse_iterator rbegin() noexcept
+	{
+		return reverse_iterator(end());
+	}
+
+	const_reverse_iterator rbegin() const noexcept
+	{
+		return const_reverse_iterator(end());
+	}
+
+	reverse_iterator rend() noexcept
+	{
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rend() const noexcept
+	{
+		return const_reverse_iterator(begin());
+	}
+
+	/**
+	 * emplace() - Construct entry and insert it when key is not yet used
+	 * @args: arguments to construct value_type
+	 *
+	 * The entry has to be constructed to know its key. It is destroyed again
+	 * when the key already exists. try_emplace() avoids this.
+	 *
+	 * Return: iterator to the new or already existing entry and whether the
+	 *  new entry was inserted
+	 */
+	template <class... Args>
+	std::pair<iterator, bool> emplace(Args &&...args)
+	{
+		node *n = create_node(std::forward<Args>(args)...);
+		RB_LINK *link;
+		rb_node *parent;
+		rb_node *found;
+
+		found = find_link(n->value.first, &link, &parent);
+		if (found) {
+			destroy_node(n, mr_);
+			return { iterator(found, &root_), false };
+		}
+
+		link_node(n, link, parent);
+		return { iterator(n, &root_), true };
+	}
+
+	/**
+	 * try_emplace() - Construct value in place when key is not yet used
+	 * @key: key of the new entry
+	 * @args: arguments to construct mapped_type
+	 *
+	 * Nothing is allocated or constructed when the key already exists.
+	 *
+	 * Return: iterator to the new or already existing entry and whether the
+	 *  new entry was inserted
+	 */
+	template <class KArg, class... Args>
+	std::pair<iterator, bool> try_emplace(KArg &&key, Args &&...args)
+	{
+		RB_LINK *link;
+		rb_node *parent;
+		rb_node *found;
+		node *n;
+
+		found = find_link(key, &link, &parent);
+		if (found)
+			return { iterator(found, &root_), false };
+
+		n = create_node(std::piecewise_construct,
+				std::forward_as_tuple(std::forward<KArg>(key)),
+				std::forward_as_tuple(std::forward<Args>(args)...));
+		link_node(n, link, parent);
+		return { iterator(n, &root_), true };
+	}
+
+	std::pair<iterator, bool> insert(value_type &&value)
+	{
+		return emplace(std::move(value));
+	}
+
+	std::pair<iterator, bool> insert(const value_type &value)
+	{
+		return emplace(value);
+	}
+
+	/**
+	 * insert() - Insert extracted entry
+	 * @nh: node handle from extract() of a map with an equal memory resource
+	 *
+	 * Return: position of the inserted or blocking entry. The node handle is
+	 *  returned when its key already exists
+	 */
+	insert_return_type insert(node_type &&nh)
+	{
+		RB_LINK *link;
+		rb_node *parent;
+		rb_node *found;
+		node *n;
+
+		if (nh.empty())
+			return { end(), false, node_type() };
+
+		/* node is later returned to the memory resource of this map */
+		assert(nh.mr_ == mr_ || *nh.mr_ == *mr_);
+
+		found = find_link(nh.key(), &link, &parent);
+		if (found)
+			return { iterator(found, &root_), false, std::move(nh) };
+
+		n = nh.release();
+		link_node(n, link, parent);
+		return { iterator(n, &root_), true, node_type() };
+	}
+
+	mapped_type &operator[](const key_type &key)
+	{
+		return try_emplace(key).first->second;
+	}
+
+	mapped_type &operator[](key_type &&key)
+	{
+		return try_emplace(std::move(key)).first->second;
+	}
+
+	mapped_type &at(const key_type &key)
+	{
+		iterator it = find(key);
+
+		if (it == end())
+			throw std::out_of_range("rb::map::at");
+
+		return it->second;
+	}
+
+	const mapped_type &at(const key_type &key) const
+	{
+		const_iterator it = find(key);
+
+		if (it == end())
+			throw std::out_of_range("rb::map::at");
+
+		return it->second;
+	}
+
+	iterator find(const key_type &key)
+	{
+		return iterator(find_node(key), &root_);
+	}
+
+	const_iterator find(const key_type &key) const
+	{
+		return const_iterator(find_node(key), &root_);
+	}
+
+	size_type count(const key_type &key) const
+	{
+		return find_node(key) ? 1 : 0;
+	}
+
+	bool contains(const key_type &key) const
+	{
+		return find_node(key);
+	}
+
+	iterator lower_bound(const key_type &key)
+	{
+		return iterator(lower_bound_node(key), &root_);
+	}
+
+	const_iterator lower_bound(const key_type &key) const
+	{
+		return const_iterator(lower_bound_node(key), &root_);
+	}
+
+	iterator upper_bound(const key_type &key)
+	{
+		return iterator(upper_bound_node(key), &root_);
+	}
+
+	const_iterator upper_bound(const key_type &key) const
+	{
+		return const_iterator(upper_bound_node(key), &root_);
+	}
+
+	/**
+	 * extract() - Unlink entry and transfer its ownership to a node handle
+	 * @pos: iterator to the entry
+	 *
+	 * Return: node handle owning the entry
+	 */
+	node_type extract(const_iterator pos)
+	{
+		rb_erase(pos.node_, &root_);
+		size_--;
+
+		return node_type(to_node(pos.node_), mr_);
+	}
+
+	node_type extract(const key_type &key)
+	{
+		rb_node *found = find_node(key);
+
+		if (!found)
+			return node_type();
+
+		return extract(const_iterator(found, &root_));
+	}
+
+	iterator erase(const_iterator pos)
+	{
+		rb_node *next = rb_next(pos.node_);
+
+		rb_erase(pos.node_, &root_);
+		size_--;
+		destroy_node(to_node(pos.node_), mr_);
+
+		return iterator(next, &root_);
+	}
+
+	iterator erase(iterator pos)
+	{
+		return erase(const_iterator(pos));
+	}
+
+	size_type erase(const key_type &key)
+	{
+		rb_node *found = find_node(key);
+
+		if (!found)
+			return 0;
+
+		erase(const_iterator(found, &root_));
+		return 1;
+	}
+
+	/**
+	 * clear() - Destroy all entries
+	 *
+	 * The leafs are destroyed first. No rebalancing is necessary.
+	 */
+	void clear() noexcept
+	{
+		rb_node *rbnode = rb_link_get(&root_.node);
+		rb_node *parent;
+
+		while (rbnode) {
+			if (rb_left(rbnode)) {
+				rbnode = rb_left(rbnode);
+				continue;
+			}
+
+			if (rb_right(rbnode)) {
+				rbnode = rb_right(rbnode);
+				continue;
+			}
+
+			parent = rb_parent(rbnode);
+			if (parent) {
+				if (rb_left(parent) == rbnode)
+					rb_link_set(&parent->left, nullptr);
+				else
+					rb_link_set(&parent->right, nullptr);
+			}
+
+			destroy_node(to_node(rbnode), mr_);
+			rbnode = parent;
+		}
+
+		INIT_RB_ROOT(&root_);
+		size_ = 0;
+	}
+
+	key_compare key_comp() const
+	{
+		return comp_;
+	}
+
+	const struct rb_root *root() const noexcept
+	{
+		return &root_;
+	}
+
+private:
+	template <class... Args>
+	node *create_node(Args &&...args)
+	{
+		void *mem = mr_->allocate(sizeof(node), alignof(node));
+
+		try {
+			return ::new (mem) node(std::forward<Args>(args)...);
+		} catch (...) {
+			mr_->deallocate(mem, sizeof(node), alignof(node));
+			throw;
+		}
+	}
+
+	static void destroy_node(node *n, std::pmr::memory_resource *mr)
+	{
+		n->~node();
+		mr->deallocate(n, sizeof(node), alignof(node));
+	}
+
+	void link_node(node *n, RB_LINK *link, rb_node *parent)
+	{
+		rb_insert(n, parent, link, &root_);
+		size_++;
+	}
+
+	rb_node *find_link(const key_type &key, RB_LINK **link,
+			   rb_node **parent)
+	{
+		RB_LINK *rb_link = &root_.node;
+		const key_type *cur;
+
+		*parent = nullptr;
+		while (rb_link_get(rb_link)) {
+			*parent = rb_link_get(rb_link);
+			cur = &to_node(*parent)->value.first;
+
+			if (comp_(key, *cur))
+				rb_link = &(*parent)->left;
+			else if (comp_(*cur, key))
+				rb_link = &(*parent)->right;
+			else
+				return *parent;
+		}
+
+		*link = rb_link;
+		return nullptr;
+	}
+
+	rb_node *find_node(const key_type &key) const
+	{
+		rb_node *rbnode = rb_link_get(&root_.node);
+		const key_type *cur;
+
+		while (rbnode) {
+			cur = &to_node(rbnode)->value.first;
+
+			if (comp_(key, *cur))
+				rbnode = rb_left(rbnode);
+			else if (comp_(*cur, key))
+				rbnode = rb_right(rbnode);
+			else
+				return rbnode;
+		}
+
+		return nullptr;
+	}
+
+	rb_node *lower_bound_node(const key_type &key) const
+	{
+		rb_node *rbnode = rb_link_get(&root_.node);
+		rb_node *result = nullptr;
+
+		while (rbnode) {
+			if (comp_(to_node(rbnode)->value.first, key)) {
+				rbnode = rb_right(rbnode);
+			} else {
+				result = rbnode;
+				rbnode = rb_left(rbnode);
+			}
+		}
+
+		return result;
+	}
+
+	rb_node *upper_bound_node(const key_type &key) const
+	{
+		rb_node *rbnode = rb_link_get(&root_.node);
+		rb_node *result = nullptr;
+
+		while (rbnode) {
+			if (comp_(key, to_node(rbnode)->value.first)) {
+				result = rbnode;
+				rbnode = rb_left(rbnode);
+			} else {
+				rbnode = rb_right(rbnode);
+			}
+		}
+
+		return result;
+	}
+
+	struct rb_root root_;
+	std::pmr::memory_resource *mr_;
+	Compare comp_;
+	size_type size_ = 0;
+};
+
+} /* namespace rb */
+
+#endif /* __RBTREE_MAP_HPP__ */
@@ -0,0 +1,966 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions - parallel operations
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#ifndef _POSIX_C_SOURCE
+/* required for pthread and sysconf */
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "rbtree-parallel.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* number of pieces per thread to balance different piece sizes */
+#define RB_PIECES_PER_THREAD 8
+
+/* runs which are sorted via insertion sort */
+#define RB_SORT_RUN 16
+
+/* minimal number of nodes before a sort is split over two threads */
+#define RB_SORT_PARALLEL_MIN 8192
+
+/* cost of a node in a rebuild relative to one level of an insert descent */
+#define RB_BATCH_REBUILD_COST 8
+
+/**
+ * struct rb_piece - part of the tree processed by a single thread
+ * @node: root of the part
+ * @subtree: !0 - complete subtree under @node, 0 - only @node
+ */
+struct rb_piece {
+	struct rb_node *node;
+	int subtree;
+};
+
+struct rb_parallel_job;
+
+/**
+ * struct rb_worker - thread with its own range of pieces
+ * @lock: protects @head and @tail
+ * @head: next piece processed by the owner
+ * @tail: end of the range, pieces are stolen from here by other workers
+ * @job: shared job information
+ * @thread: thread handle
+ * @started: @thread was created and has to be joined
+ */
+struct rb_worker {
+	pthread_mutex_t lock;
+	size_t head;
+	size_t tail;
+	struct rb_parallel_job *job;
+	pthread_t thread;
+	int started;
+};
+
+/**
+ * struct rb_parallel_job - shared state of a parallel operation
+ * @pieces: pieces of the tree in tree order
+ * @piece_count: number of entries in @pieces
+ * @workers: all workers (the first one is the calling thread)
+ * @worker_count: number of entries in @workers
+ * @fn: callback for each node (for_each)
+ * @ops: reduction operations (reduce)
+ * @arg: argument for @fn and @ops
+ * @accs: accumulator for each piece (reduce)
+ * @stride: aligned size of each accumulator in @accs
+ */
+struct rb_parallel_job {
+	struct rb_piece *pieces;
+	size_t piece_count;
+	struct rb_worker *workers;
+	unsigned int worker_count;
+	void (*fn)(struct rb_node *node, void *arg);
+	const struct rb_reduce_ops *ops;
+	void *arg;
+	unsigned char *accs;
+	size_t stride;
+};
+
+/* alignment for accumulators in the shared buffer */
+union rb_max_align {
+	long double ld;
+	double d;
+	long l;
+	void *p;
+	void (*fp)(void);
+};
+
+/**
+ * rb_collect_pieces() - Split tree in subtrees with equal black height
+ * @node: current node
+ * @levels: number of black levels to split before a subtree is a piece
+ * @pieces: array to store the pieces, NULL to only count them
+ * @count: number of already collected pieces
+ *
+ * Red nodes always belong to the 3-node of their black parent and are split
+ * together with it. All subtree pieces therefore start at a black node and
+ * have the same black height. Their sizes differ at most by the factor
+ * 2^(black height).
+ */
+static void rb_collect_pieces(struct rb_node *node, unsigned int levels,
+			      struct rb_piece *pieces, size_t *count)
+{
+	if (!node)
+		return;
+
+	if (rb_color(node) == RB_BLACK) {
+		if (levels == 0) {
+			if (pieces) {
+				pieces[*count].node = node;
+				pieces[*count].subtree = 1;
+			}
+			(*count)++;
+			return;
+		}
+
+		levels--;
+	}
+
+	rb_collect_pieces(rb_left(node), levels, pieces, count);
+
+	if (pieces) {
+		pieces[*count].node = node;
+		pieces[*count].subtree = 0;
+	}
+	(*count)++;
+
+	rb_collect_pieces(rb_right(node), levels, pieces, count);
+}
+
+static void rb_process_piece(struct rb_parallel_job *job, size_t index)
+{
+	const struct rb_piece *piece = &job->pieces[index];
+	struct rb_node *node = piece->node;
+	struct rb_node *last = node;
+	void *acc = NULL;
+
+	if (job->ops) {
+		acc = job->accs + index * job->stride;
+		job->ops->init(acc, job->arg);
+	}
+
+	if (piece->subtree) {
+		while (rb_left(node))
+			node = rb_left(node);
+
+		while (rb_right(last))
+			last = rb_right(last);
+	}
+
+	for (;;) {
+		if (job->ops)
+			job->ops->accumulate(acc, node, job->arg);
+		else
+			job->fn(node, job->arg);
+
+		if (node == last)
+			break;
+
+		node = rb_next(node);
+	}
+}
+
+static int rb_worker_pop(struct rb_worker *worker, size_t *index)
+{
+	int found = 0;
+
+	pthread_mutex_lock(&worker->lock);
+	if (worker->head < worker->tail) {
+		*index = worker->head++;
+		found = 1;
+	}
+	pthread_mutex_unlock(&worker->lock);
+
+	return found;
+}
+
+static int rb_worker_steal(struct rb_worker *worker, size_t *index)
+{
+	int found = 0;
+
+	pthread_mutex_lock(&worker->lock);
+	if (worker->head < worker->tail) {
+		*index = --worker->tail;
+		found = 1;
+	}
+	pthread_mutex_unlock(&worker->lock);
+
+	return found;
+}
+
+static void *rb_worker_run(void *data)
+{
+	struct rb_worker *self = (struct rb_worker *)data;
+	struct rb_parallel_job *job = self->job;
+	size_t self_id = (size_t)(self - job->workers);
+	size_t count = job->worker_count;
+	struct rb_worker *victim;
+	size_t index = 0;
+	size_t i;
+
+	for (;;) {
+		if (rb_worker_pop(self, &index)) {
+			rb_process_piece(job, index);
+			continue;
+		}
+
+		/* own range is empty - steal from the end of other ranges */
+		for (i = 1; i < count; i++) {
+			victim = &job->workers[(self_id + i) % count];
+			if (rb_worker_steal(victim, &index))
+				break;
+		}
+
+		if (i == count)
+			break;
+
+		rb_process_piece(job, index);
+	}
+
+	return NULL;
+}
+
+static unsigned int rb_parallel_threads(unsigned int threads)
+{
+	long cpus;
+
+	if (threads)
+		return threads;
+
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpus < 1)
+		return 1;
+
+	return (unsigned int)cpus;
+}
+
+/**
+ * rb_parallel_run() - Split tree and process the pieces in parallel
+ * @root: pointer to the root of the tree
+ * @threads: number of threads (including the caller), 0 for one per CPU
+ * @job: job with prepared callbacks
+ *
+ * Threads which cannot be created are ignored. Their pieces are stolen by
+ * the other workers.
+ *
+ * Return: 0 on success, -ENOMEM when the job could not be allocated
+ */
+static int rb_parallel_run(const struct rb_root *root, unsigned int threads,
+			   struct rb_parallel_job *job)
+{
+	const size_t align = sizeof(union rb_max_align);
+	struct rb_node *node;
+	unsigned int black_height = 0;
+	unsigned int levels = 0;
+	size_t target;
+	size_t first;
+	unsigned int i;
+	int ret = 0;
+
+	job->pieces = NULL;
+	job->piece_count = 0;
+	job->workers = NULL;
+	job->accs = NULL;
+
+	if (rb_empty(root))
+		return 0;
+
+	threads = rb_parallel_threads(threads);
+
+	for (node = rb_link_get(&root->node); node; node = rb_left(node)) {
+		if (rb_color(node) == RB_BLACK)
+			black_height++;
+	}
+
+	target = (size_t)threads * RB_PIECES_PER_THREAD;
+	while (threads > 1 && levels + 1 < black_height &&
+	       ((size_t)1 << levels) < target)
+		levels++;
+
+	rb_collect_pieces(rb_link_get(&root->node), levels, NULL,
+			  &job->piece_count);
+
+	job->pieces = (struct rb_piece *)malloc(sizeof(*job->pieces) *
+						job->piece_count);
+	if (!job->pieces)
+		return -ENOMEM;
+
+	job->piece_count = 0;
+	rb_collect_pieces(rb_link_get(&root->node), levels, job->pieces,
+			  &job->piece_count);
+
+	if (threads > job->piece_count)
+		threads = (unsigned int)job->piece_count;
+
+	if (job->ops) {
+		job->stride = (job->ops->acc_size + align - 1) / align * align;
+		job->accs = (unsigned char *)malloc(job->stride *
+						    job->piece_count);
+		if (!job->accs) {
+			ret = -ENOMEM;
+			goto free_pieces;
+		}
+	}
+
+	job->workers = (struct rb_worker *)malloc(sizeof(*job->workers) *
+						  threads);
+	if (!job->workers) {
+		ret = -ENOMEM;
+		goto free_accs;
+	}
+	job->worker_count = threads;
+
+	/* each worker starts with a contiguous range of pieces */
+	first = 0;
+	for (i = 0; i < threads; i++) {
+		pthread_mutex_init(&job->workers[i].lock, NULL);
+		job->workers[i].head = first;
+		first = job->piece_count * (i + 1) / threads;
+		job->workers[i].tail = first;
+		job->workers[i].job = job;
+		job->workers[i].started = 0;
+	}
+
+	for (i = 1; i < threads; i++) {
+		if (pthread_create(&job->workers[i].thread, NULL, rb_worker_run,
+				   &job->workers[i]) == 0)
+			job->workers[i].started = 1;
+	}
+
+	rb_worker_run(&job->workers[0]);
+
+	for (i = 0; i < threads; i++) {
+		if (job->workers[i].started)
+			pthread_join(job->workers[i].thread, NULL);
+
+		pthread_mutex_destroy(&job->workers[i].lock);
+	}
+
+	free(job->workers);
+	job->workers = NULL;
+
+	return 0;
+
+free_accs:
+	free(job->accs);
+	job->accs = NULL;
+free_pieces:
+	free(job->pieces);
+	job->pieces = NULL;
+
+	return ret;
+}
+
+/**
+ * rb_parallel_for_each() - Call function for each node using multiple threads
+ * @root: pointer to the root of the tree
+ * @threads: number of threads (including the caller), 0 for one per CPU
+ * @fn: function called for each node
+ * @arg: argument for @fn
+ *
+ * The tree is split near the root into subtrees with equal black height.
+ * These pieces are distributed over the threads. Idle threads steal pieces
+ * from the other threads. @fn is called concurrently for different nodes and
+ * in no particular order. The tree must not be modified until the function
+ * returns.
+ *
+ * Return: 0 on success, -ENOMEM when the job could not be allocated
+ */
+int rb_parallel_for_each(const struct rb_root *root, unsigned int threads,
+			 void (*fn)(struct rb_node *node, void *arg),
+			 void *arg)
+{
+	struct rb_parallel_job job;
+	int ret;
+
+	memset(&job, 0, sizeof(job));
+	job.fn = fn;
+	job.arg = arg;
+
+	ret = rb_parallel_run(root, threads, &job);
+	free(job.pieces);
+
+	return ret;
+}
+
+/**
+ * rb_parallel_reduce() - Reduce all nodes in tree order using multiple threads
+ * @root: pointer to the root of the tree
+ * @threads: number of threads (including the caller), 0 for one per CPU
+ * @ops: reduction operations
+ * @arg: argument for the operations
+ * @result: accumulator (@ops->acc_size bytes) to store the result
+ *
+ * Each piece of the tree (see rb_parallel_for_each) is accumulated in its own
+ * accumulator. The accumulators are afterwards combined in tree order by the
+ * calling thread.
+ *
+ * Return: 0 on success, -ENOMEM when the job could not be allocated
+ */
+int rb_parallel_reduce(const struct rb_root *root, unsigned int threads,
+		       const struct rb_reduce_ops *ops, void *arg,
+		       void *result)
+{
+	struct rb_parallel_job job;
+	size_t i;
+	int ret;
+
+	memset(&job, 0, sizeof(job));
+	job.ops = ops;
+	job.arg = arg;
+
+	ops->init(result, arg);
+
+	ret = rb_parallel_run(root, threads, &job);
+	if (ret < 0)
+		return ret;
+
+	for (i = 0; i < job.piece_count; i++)
+		ops->combine(result, job.accs + i * job.stride, arg);
+
+	free(job.accs);
+	free(job.pieces);
+
+	return 0;
+}
+
+/**
+ * struct rb_sort_job - part of a parallel merge sort
+ * @nodes: nodes to sort
+ * @tmp: scratch buffer with the same size as @nodes
+ * @count: number of entries in @nodes
+ * @threads: number of threads which can be used for this part
+ * @cmp: comparison function for two nodes
+ */
+struct rb_sort_job {
+	struct rb_node **nodes;
+	struct rb_node **tmp;
+	size_t count;
+	unsigned int threads;
+	int (*cmp)(const struct rb_node *node1, const struct rb_node *node2);
+};
+
+static void *rb_sort_run(void *data);
+
+/**
+ * rb_sort_nodes() - Stable merge sort of nodes
+ * @job: nodes to sort
+ *
+ * The first half is sorted by a new thread when more than one thread is
+ * available for @job. The calling thread sorts the second half and merges
+ * both halves afterwards.
+ */
+static void rb_sort_nodes(const struct rb_sort_job *job)
+{
+	int (*cmp)(const struct rb_node *node1,
+		   const struct rb_node *node2) = job->cmp;
+	struct rb_node **nodes = job->nodes;
+	struct rb_sort_job left, right;
+	struct rb_node *node;
+	pthread_t thread;
+	int started = 0;
+	size_t i, j, k;
+
+	if (job->count <= RB_SORT_RUN) {
+		for (i = 1; i < job->count; i++) {
+			node = nodes[i];
+			for (j = i; j > 0 && cmp(nodes[j - 1], node) > 0; j--)
+				nodes[j] = nodes[j - 1];
+			nodes[j] = node;
+		}
+
+		return;
+	}
+
+	left = *job;
+	left.count = job->count / 2;
+	right = *job;
+	right.nodes += left.count;
+	right.tmp += left.count;
+	right.count -= left.count;
+
+	if (job->threads > 1 && job->count >= RB_SORT_PARALLEL_MIN) {
+		left.threads = job->threads / 2;
+		right.threads = job->threads - left.threads;
+
+		if (pthread_create(&thread, NULL, rb_sort_run, &left) == 0)
+			started = 1;
+	}
+
+	if (!started)
+		rb_sort_nodes(&left);
+	rb_sort_nodes(&right);
+
+	if (started)
+		pthread_join(thread, NULL);
+
+	/* merge both halves - equal nodes from the first half stay first */
+	i = 0;
+	j = left.count;
+	k = 0;
+	while (i < left.count && j < job->count) {
+		if (cmp(nodes[i], nodes[j]) <= 0)
+			job->tmp[k++] = nodes[i++];
+		else
+			job->tmp[k++] = nodes[j++];
+	}
+
+	while (i < left.count)
+		job->tmp[k++] = nodes[i++];
+
+	memcpy(nodes, job->tmp, sizeof(*nodes) * k);
+}
+
+static void *rb_sort_run(void *data)
+{
+	rb_sort_nodes((const struct rb_sort_job *)data);
+
+	return NULL;
+}
+
+/**
+ * rb_batch_rebuild() - Merge sorted batch with tree and rebuild it
+ * @root: pointer to the root of the tree
+ * @nodes: sorted nodes to insert
+ * @count: number of entries in @nodes
+ * @cmp: comparison function for two nodes
+ *
+ * Return: 0 on success, -ENOMEM when the merge buffer could not be allocated
+ */
+static int rb_batch_rebuild(struct rb_root *root, struct rb_node **nodes,
+			    size_t count,
+			    int (*cmp)(const struct rb_node *node1,
+				       const struct rb_node *node2))
+{
+	struct rb_node **merged;
+	struct rb_node *node;
+	size_t size = 0;
+	size_t i = 0;
+	size_t k = 0;
+
+	for (node = rb_first(root); node; node = rb_next(node))
+		size++;
+
+	merged = (struct rb_node **)malloc(sizeof(*merged) * (size + count));
+	if (!merged)
+		return -ENOMEM;
+
+	/* nodes already in the tree stay in front of equal new nodes */
+	node = rb_first(root);
+	while (node && i < count) {
+		if (cmp(node, nodes[i]) <= 0) {
+			merged[k++] = node;
+			node = rb_next(node);
+		} else {
+			merged[k++] = nodes[i++];
+		}
+	}
+
+	for (; node; node = rb_next(node))
+		merged[k++] = node;
+
+	while (i < count)
+		merged[k++] = nodes[i++];
+
+	rb_build(root, merged, k);
+	free(merged);
+
+	return 0;
+}
+
+/**
+ * rb_batch_prefer_rebuild() - Check if rebuild is cheaper than inserts
+ * @root: pointer to the root of the tree
+ * @count: number of new nodes
+ *
+ * The tree size is estimated from its black height h. A LLRB with this black
+ * height has between 2^h - 1 and 4^h - 1 nodes - the estimate uses 2^(1.5h).
+ *
+ * Return: !0 when the tree should be rebuilt, 0 for single inserts
+ */
+static int rb_batch_prefer_rebuild(const struct rb_root *root, size_t count)
+{
+	unsigned int black_height = 0;
+	unsigned int shift;
+	unsigned int depth = 0;
+	struct rb_node *node;
+	size_t size;
+	size_t total;
+
+	for (node = rb_link_get(&root->node); node; node = rb_left(node)) {
+		if (rb_color(node) == RB_BLACK)
+			black_height++;
+	}
+
+	shift = black_height + black_height / 2;
+	if (shift >= sizeof(size) * 8 - 1)
+		return 0;
+
+	size = ((size_t)1 << shift) - 1;
+	if (size > (size_t)-1 - count)
+		return 0;
+
+	total = size + count;
+	for (; total > 1; total >>= 1)
+		depth++;
+
+	return count / RB_BATCH_REBUILD_COST * depth >= size + count;
+}
+
+/**
+ * rb_insert_batch() - Sort batch of nodes in parallel and add them to tree
+ * @root: pointer to the root of the tree
+ * @nodes: array of nodes to insert, is sorted during the call
+ * @count: number of entries in @nodes
+ * @threads: number of threads (including the caller), 0 for one per CPU
+ * @cmp: comparison function which returns <0, 0 or >0 when first node is
+ *  smaller, equal or larger than the second node
+ *
+ * The batch is first sorted with a stable, parallel merge sort. The sorted
+ * batch is then either inserted one by one with the previous node as hint
+ * (small batches) or merged with the tree into a new balanced tree in O(n + k)
+ * (large batches relative to the tree size). The strategy is chosen by
+ * comparing the estimated cost of k descents with a full rebuild.
+ *
+ * Nodes which compare equal are inserted after the nodes already in the tree
+ * and keep their order from @nodes.
+ *
+ * Return: 0 on success, -ENOMEM when the sort buffer could not be allocated.
+ *  The tree is not modified on errors
+ */
+int rb_insert_batch(struct rb_root *root, struct rb_node **nodes,
+		    size_t count, unsigned int threads,
+		    int (*cmp)(const struct rb_node *node1,
+			       const struct rb_node *node2))
+{
+	struct rb_sort_job job;
+	struct rb_node *hint;
+	size_t i;
+
+	if (!count)
+		return 0;
+
+	job.tmp = (struct rb_node **)malloc(sizeof(*job.tmp) * count);
+	if (!job.tmp)
+		return -ENOMEM;
+
+	job.nodes = nodes;
+	job.count = count;
+	job.threads = rb_parallel_threads(threads);
+	job.cmp = cmp;
+	rb_sort_nodes(&job);
+	free(job.tmp);
+
+	/* single inserts are the fallback when the rebuild buffer is missing */
+	if (rb_batch_prefer_rebuild(root, count) &&
+	    rb_batch_rebuild(root, nodes, count, cmp) == 0)
+		return 0;
+
+	hint = NULL;
+	for (i = 0; i < count; i++) {
+		rb_insert_hint(nodes[i], hint, root, cmp);
+		hint = nodes[i];
+	}
+
+	return 0;
+}
+
+/* minimal black height of a tree before set operations are forked */
+#define RB_SET_PARALLEL_HEIGHT 8
+
+/**
+ * enum rb_set_op - set operation on two trees
+ * @RB_SET_UNION: nodes which are in any tree
+ * @RB_SET_INTERSECTION: nodes which are in both trees
+ * @RB_SET_DIFFERENCE: nodes which are only in the first tree
+ */
+enum rb_set_op {
+	RB_SET_UNION,
+	RB_SET_INTERSECTION,
+	RB_SET_DIFFERENCE
+};
+
+/**
+ * struct rb_set_job - set operation on two (sub)trees
+ * @a: first tree, receives the result
+ * @b: second tree, is consumed
+ * @threads: number of threads which can be used for this job
+ * @op: set operation
+ * @cmp: comparison function for two nodes
+ * @drop: called for each node which is not part of the result, can be NULL
+ * @arg: argument for @drop
+ */
+struct rb_set_job {
+	struct rb_root a;
+	struct rb_root b;
+	unsigned int threads;
+	enum rb_set_op op;
+	int (*cmp)(const struct rb_node *node1, const struct rb_node *node2);
+	void (*drop)(struct rb_node *node, void *arg);
+	void *arg;
+};
+
+/**
+ * rb_set_drop() - Call drop function for all nodes of a detached subtree
+ * @job: set operation with drop function
+ * @node: root of the subtree
+ */
+static void rb_set_drop(const struct rb_set_job *job, struct rb_node *node)
+{
+	struct rb_node *left;
+	struct rb_node *right;
+
+	if (!job->drop)
+		return;
+
+	/* drop function is allowed to free the node */
+	while (node) {
+		left = rb_left(node);
+		right = rb_right(node);
+
+		rb_set_drop(job, left);
+		job->drop(node, job->arg);
+		node = right;
+	}
+}
+
+/**
+ * rb_set_join2() - Join two trees without a node between them
+ * @root: pointer to rb root for the result
+ * @left: pointer to rb root of tree with smaller nodes
+ * @right: pointer to rb root of tree with larger nodes
+ */
+static void rb_set_join2(struct rb_root *root, struct rb_root *left,
+			 struct rb_root *right)
+{
+	struct rb_node *node;
+
+	if (rb_empty(right)) {
+		rb_link_set(&root->node, rb_link_get(&left->node));
+		return;
+	}
+
+	node = rb_first(right);
+	rb_erase(node, right);
+	rb_join(root, left, node, right);
+}
+
+static void *rb_set_run(void *data);
+
+/**
+ * rb_set_operation() - Divide and conquer set operation via split and join
+ * @job: set operation with both trees
+ *
+ * The first tree is split at its root. The second tree is split at the same
+ * node. The operation is then done recursively on both halves and the
+ * results are joined again. The left halves are processed by a new thread
+ * when enough threads are available and the trees are large enough.
+ */
+static void rb_set_operation(struct rb_set_job *job)
+{
+	struct rb_set_job left, right;
+	struct rb_node *found;
+	struct rb_node *pivot;
+	struct rb_node *node;
+	pthread_t thread;
+	int started = 0;
+	unsigned int height = 0;
+
+	if (rb_empty(&job->a)) {
+		if (job->op == RB_SET_UNION)
+			rb_link_set(&job->a.node, rb_link_get(&job->b.node));
+		else
+			rb_set_drop(job, rb_link_get(&job->b.node));
+
+		INIT_RB_ROOT(&job->b);
+		return;
+	}
+
+	if (rb_empty(&job->b)) {
+		if (job->op == RB_SET_INTERSECTION) {
+			rb_set_drop(job, rb_link_get(&job->a.node));
+			INIT_RB_ROOT(&job->a);
+		}
+
+		return;
+	}
+
+	left = *job;
+	right = *job;
+
+	/* split at root of first tree is O(1) - only detaches the children */
+	pivot = rb_split(&job->a, rb_link_get(&job->a.node), job->cmp,
+			 &left.a, &right.a);
+	found = rb_split(&job->b, pivot, job->cmp, &left.b, &right.b);
+
+	for (node = rb_link_get(&left.a.node); node; node = rb_left(node)) {
+		if (rb_color(node) == RB_BLACK)
+			height++;
+	}
+
+	if (job->threads > 1 && height >= RB_SET_PARALLEL_HEIGHT) {
+		left.threads = job->threads / 2;
+		right.threads = job->threads - left.threads;
+
+		if (pthread_create(&thread, NULL, rb_set_run, &left) == 0)
+			started = 1;
+	}
+
+	if (!started)
+		rb_set_operation(&left);
+	rb_set_operation(&right);
+
+	if (started)
+		pthread_join(thread, NULL);
+
+	switch (job->op) {
+	case RB_SET_UNION:
+		if (found && job->drop)
+			job->drop(found, job->arg);
+		rb_join(&job->a, &left.a, pivot, &right.a);
+		break;
+	case RB_SET_INTERSECTION:
+		if (found) {
+			if (job->drop)
+				job->drop(found, job->arg);
+			rb_join(&job->a, &left.a, pivot, &right.a);
+		} else {
+			if (job->drop)
+				job->drop(pivot, job->arg);
+			rb_set_join2(&job->a, &left.a, &right.a);
+		}
+		break;
+	case RB_SET_DIFFERENCE:
+		if (found) {
+			if (job->drop) {
+				job->drop(found, job->arg);
+				job->drop(pivot, job->arg);
+			}
+			rb_set_join2(&job->a, &left.a, &right.a);
+		} else {
+			rb_join(&job->a, &left.a, pivot, &right.a);
+		}
+		break;
+	}
+}
+
+static void *rb_set_run(void *data)
+{
+	rb_set_operation((struct rb_set_job *)data);
+
+	return NULL;
+}
+
+/**
+ * rb_set_start() - Run set operation on two trees
+ * @root: pointer to rb root of the first tree, receives the result
+ * @other: pointer to rb root of the second tree, is empty afterwards
+ * @threads: number of threads (including the caller), 0 for one per CPU
+ * @op: set operation
+ * @cmp: comparison function for two nodes
+ * @drop: called for each node which is not part of the result, can be NULL
+ * @arg: argument for @drop
+ */
+static void rb_set_start(struct rb_root *root, struct rb_root *other,
+			 unsigned int threads, enum rb_set_op op,
+			 int (*cmp)(const struct rb_node *node1,
+				    const struct rb_node *node2),
+			 void (*drop)(struct rb_node *node, void *arg),
+			 void *arg)
+{
+	struct rb_set_job job;
+
+	rb_link_set(&job.a.node, rb_link_get(&root->node));
+	rb_link_set(&job.b.node, rb_link_get(&other->node));
+	job.threads = rb_parallel_threads(threads);
+	job.op = op;
+	job.cmp = cmp;
+	job.drop = drop;
+	job.arg = arg;
+
+	rb_set_operation(&job);
+
+	rb_link_set(&root->node, rb_link_get(&job.a.node));
+	INIT_RB_ROOT(other);
+}
+
+/**
+ * rb_union() - Add all nodes of another tree using multiple threads
+ * @root: pointer to rb root of the first tree, receives the result
+ * @other: pointer to rb root of the second tree, is empty afterwards
+ * @threads: number of threads (including the caller), 0 for one per CPU
+ * @cmp: comparison function which returns <0, 0 or >0 when first node is
+ *  smaller, equal or larger than the second node
+ * @drop: called for each node of @other which is equal to a node in @root,
+ *  can be NULL
+ * @arg: argument for @drop
+ *
+ * Both trees are combined via split and join in O(m log(n/m + 1)) work for
+ * trees with m <= n nodes. The recursive calls are distributed over multiple
+ * threads. The nodes of @root are kept when both trees have equal nodes.
+ *
+ * Both trees must not contain nodes which are equal to other nodes of the
+ * same tree. @drop can be called concurrently from multiple threads and is
+ * allowed to free the node.
+ */
+void rb_union(struct rb_root *root, struct rb_root *other,
+	      unsigned int threads,
+	      int (*cmp)(const struct rb_node *node1,
+			 const struct rb_node *node2),
+	      void (*drop)(struct rb_node *node, void *arg), void *arg)
+{
+	rb_set_start(root, other, threads, RB_SET_UNION, cmp, drop, arg);
+}
+
+/**
+ * rb_intersection() - Keep only nodes which are also in another tree
+ * @root: pointer to rb root of the first tree, receives the result
+ * @other: pointer to rb root of the second tree, is empty afterwards
+ * @threads: number of threads (including the caller), 0 for one per CPU
+ * @cmp: comparison function which returns <0, 0 or >0 when first node is
+ *  smaller, equal or larger than the second node
+ * @drop: called for each node of @root which is not in @other and for all
+ *  nodes of @other, can be NULL
+ * @arg: argument for @drop
+ *
+ * See rb_union for the runtime and the requirements of the trees.
+ */
+void rb_intersection(struct rb_root *root, struct rb_root *other,
+		     unsigned int threads,
+		     int (*cmp)(const struct rb_node *node1,
+				const struct rb_node *node2),
+		     void (*drop)(struct rb_node *node, void *arg), void *arg)
+{
+	rb_set_start(root, other, threads, RB_SET_INTERSECTION, cmp, drop,
+		     arg);
+}
+
+/**
+ * rb_difference() - Remove nodes which are also in another tree
+ * @root: pointer to rb root of the first tree, receives the result
+ * @other: pointer to rb root of the second tree, is empty afterwards
+ * @threads: number of threads (including the caller), 0 for one per CPU
+ * @cmp: comparison function which returns <0, 0 or >0 when first node is
+ *  smaller, equal or larger than the second node
+ * @drop: called for each node of @root which is in @other and for all nodes
+ *  of @other, can be NULL
+ * @arg: argument for @drop
+ *
+ * See rb_union for the runtime and the requirements of the trees.
+ */
+void rb_difference(struct rb_root *root, struct rb_root *other,
+		   unsigned int threads,
+		   int (*cmp)(const struct rb_node *node1,
+			      const struct rb_node *node2),
+		   void (*drop)(struct rb_node *node, void *arg), void *arg)
+{
+	rb_set_start(root, other, threads, RB_SET_DIFFERENCE, cmp, drop, arg);
+}
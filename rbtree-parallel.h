@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: MIT */
+/* Minimal red-black-tree helper functions - parallel operations
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#ifndef __RBTREE_PARALLEL_H__
+#define __RBTREE_PARALLEL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "rbtree.h"
+
+/**
+ * struct rb_reduce_ops - operations of an ordered reduction
+ * @acc_size: size of an accumulator in bytes
+ * @init: initialize accumulator to the identity value
+ * @accumulate: add node to accumulator
+ * @combine: add accumulator @next to accumulator @acc. All nodes of @next
+ *  are larger than the nodes of @acc
+ *
+ * The accumulators are combined in tree order. @combine therefore only has to
+ * be associative, not commutative.
+ */
+struct rb_reduce_ops {
+	size_t acc_size;
+	void (*init)(void *acc, void *arg);
+	void (*accumulate)(void *acc, struct rb_node *node, void *arg);
+	void (*combine)(void *acc, const void *next, void *arg);
+};
+
+int rb_parallel_for_each(const struct rb_root *root, unsigned int threads,
+			 void (*fn)(struct rb_node *node, void *arg),
+			 void *arg);
+int rb_parallel_reduce(const struct rb_root *root, unsigned int threads,
+		       const struct rb_reduce_ops *ops, void *arg,
+		       void *result);
+int rb_insert_batch(struct rb_root *root, struct rb_node **nodes,
+		    size_t count, unsigned int threads,
+		    int (*cmp)(const struct rb_node *node1,
+			       const struct rb_node *node2));
+
+void rb_union(struct rb_root *root, struct rb_root *other,
+	      unsigned int threads,
+	      int (*cmp)(const struct rb_node *node1,
+			 const struct rb_node *node2),
+	      void (*drop)(struct rb_node *node, void *arg), void *arg);
+void rb_intersection(struct rb_root *root, struct rb_root *other,
+		     unsigned int threads,
+		     int (*cmp)(const struct rb_node *node1,
+				const struct rb_node *node2),
+		     void (*drop)(struct rb_node *node, void *arg), void *arg);
+void rb_difference(struct rb_root *root, struct rb_root *other,
+		   unsigned int threads,
+		   int (*cmp)(const struct rb_node *node1,
+			      const struct rb_node *node2),
+		   void (*drop)(struct rb_node *node, void *arg), void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RBTREE_PARALLEL_H__ */
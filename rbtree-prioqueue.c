@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions - priority queue
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include "rbtree-prioqueue.h"
+
+#include <stddef.h>
+
+/**
+ * rb_prioqueue_init() - Initialize empty priority queue
+ * @queue: pointer to the priority queue
+ * @cmp: comparison function which returns <0, 0 or >0 when first node is
+ *  smaller, equal or larger than the second node
+ */
+void rb_prioqueue_init(struct rb_prioqueue *queue,
+		       int (*cmp)(const struct rb_node *node1,
+				  const struct rb_node *node2))
+{
+	INIT_RB_ROOT(&queue->root);
+	queue->min_node = NULL;
+	queue->cmp = cmp;
+}
+
+/**
+ * rb_prioqueue_insert() - Add node to priority queue
+ * @queue: pointer to the priority queue
+ * @node: node which is not queued
+ *
+ * The node is inserted after all nodes with the same priority.
+ */
+void rb_prioqueue_insert(struct rb_prioqueue *queue, struct rb_node *node)
+{
+	RB_LINK *rb_link = &queue->root.node;
+	struct rb_node *parent = NULL;
+	struct rb_node *cur;
+	int isminimal = 1;
+
+	while ((cur = rb_link_get(rb_link))) {
+		parent = cur;
+
+		if (queue->cmp(node, cur) < 0) {
+			rb_link = &cur->left;
+		} else {
+			rb_link = &cur->right;
+			isminimal = 0;
+		}
+	}
+
+	rb_insert(node, parent, rb_link, &queue->root);
+
+	if (isminimal)
+		queue->min_node = node;
+}
+
+/**
+ * rb_prioqueue_pop() - Remove node with the smallest priority
+ * @queue: pointer to the priority queue
+ *
+ * The minimum is removed via rb_erase_first. The new minimum is returned by
+ * it and doesn't have to be searched with rb_next.
+ *
+ * Return: removed node, NULL when queue is empty
+ */
+struct rb_node *rb_prioqueue_pop(struct rb_prioqueue *queue)
+{
+	struct rb_node *node = queue->min_node;
+
+	if (!node)
+		return NULL;
+
+	queue->min_node = rb_erase_first(node, &queue->root);
+
+	return node;
+}
+
+/**
+ * rb_prioqueue_erase() - Remove queued node from priority queue
+ * @queue: pointer to the priority queue
+ * @node: queued node
+ */
+void rb_prioqueue_erase(struct rb_prioqueue *queue, struct rb_node *node)
+{
+	if (queue->min_node == node) {
+		rb_prioqueue_pop(queue);
+		return;
+	}
+
+	rb_erase(node, &queue->root);
+}
+
+/**
+ * rb_prioqueue_update() - Reposition node after its priority was changed
+ * @queue: pointer to the priority queue
+ * @node: queued node with modified priority
+ *
+ * The node is only removed and inserted again when it is no longer ordered
+ * correctly relative to its rb_prev and rb_next neighbours. Otherwise, the
+ * tree is not modified at all.
+ */
+void rb_prioqueue_update(struct rb_prioqueue *queue, struct rb_node *node)
+{
+	struct rb_node *prev = rb_prev(node);
+	struct rb_node *next = rb_next(node);
+
+	if ((!prev || queue->cmp(prev, node) <= 0) &&
+	    (!next || queue->cmp(node, next) <= 0))
+		return;
+
+	rb_prioqueue_erase(queue, node);
+	rb_prioqueue_insert(queue, node);
+}
@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: MIT */
+/* Minimal red-black-tree helper functions - priority queue
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#ifndef __RBTREE_PRIOQUEUE_H__
+#define __RBTREE_PRIOQUEUE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "rbtree.h"
+
+/**
+ * struct rb_prioqueue - priority queue with cached minimum
+ * @root: tree of the queued nodes
+ * @min_node: leftmost node of @root, NULL when queue is empty
+ * @cmp: comparison function which returns <0, 0 or >0 when first node is
+ *  smaller, equal or larger than the second node
+ *
+ * Nodes with equal priority are popped in the order they were inserted.
+ */
+struct rb_prioqueue {
+	struct rb_root root;
+	struct rb_node *min_node;
+	int (*cmp)(const struct rb_node *node1, const struct rb_node *node2);
+};
+
+/**
+ * rb_prioqueue_peek() - Get node with the smallest priority
+ * @queue: pointer to the priority queue
+ *
+ * Return: node with the smallest priority, NULL when queue is empty
+ */
+static __inline__ struct rb_node *
+rb_prioqueue_peek(const struct rb_prioqueue *queue)
+{
+	return queue->min_node;
+}
+
+void rb_prioqueue_init(struct rb_prioqueue *queue,
+		       int (*cmp)(const struct rb_node *node1,
+				  const struct rb_node *node2));
+void rb_prioqueue_insert(struct rb_prioqueue *queue, struct rb_node *node);
+struct rb_node *rb_prioqueue_pop(struct rb_prioqueue *queue);
+void rb_prioqueue_erase(struct rb_prioqueue *queue, struct rb_node *node);
+void rb_prioqueue_update(struct rb_prioqueue *queue, struct rb_node *node);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RBTREE_PRIOQUEUE_H__ */
@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions - timer queue
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include "rbtree-timer.h"
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* upper limit for the height of a red-black tree with size_t nodes */
+#define RB_TIMER_MAX_DEPTH (2 * sizeof(size_t) * CHAR_BIT)
+
+/**
+ * rb_timer_of() - Get timer of a node
+ * @node: node of a timer, can be NULL
+ *
+ * Return: timer of @node, NULL when @node is NULL
+ */
+static struct rb_timer *rb_timer_of(struct rb_node *node)
+{
+	if (!node)
+		return NULL;
+
+	return rb_entry(node, struct rb_timer, rb);
+}
+
+/**
+ * rb_timer_queue_init() - Initialize empty timer queue
+ * @queue: pointer to the timer queue
+ * @slack: maximum delay which a timer can get to share the deadline of an
+ *  already pending timer. 0 disables the coalescing of deadlines
+ */
+void rb_timer_queue_init(struct rb_timer_queue *queue, uint64_t slack)
+{
+	INIT_RB_ROOT(&queue->root);
+	queue->first = NULL;
+	queue->slack = slack;
+}
+
+/**
+ * rb_timer_coalesce() - Find deadline which can be shared with a new timer
+ * @queue: pointer to the timer queue
+ * @expires: requested deadline of the new timer
+ *
+ * Return: earliest pending deadline in [@expires, @expires + slack], @expires
+ *  when no such deadline exists
+ */
+static uint64_t rb_timer_coalesce(const struct rb_timer_queue *queue,
+				  uint64_t expires)
+{
+	struct rb_node *node = rb_link_get(&queue->root.node);
+	const struct rb_timer *bound = NULL;
+	const struct rb_timer *cur;
+
+	if (!queue->slack)
+		return expires;
+
+	while (node) {
+		cur = rb_entry(node, struct rb_timer, rb);
+
+		if (cur->expires >= expires) {
+			bound = cur;
+			node = rb_left(node);
+		} else {
+			node = rb_right(node);
+		}
+	}
+
+	if (!bound || bound->expires - expires > queue->slack)
+		return expires;
+
+	return bound->expires;
+}
+
+/**
+ * rb_timer_link() - Insert timer after all timers with the same deadline
+ * @queue: pointer to the timer queue
+ * @timer: timer with already initialized deadline
+ */
+static void rb_timer_link(struct rb_timer_queue *queue, struct rb_timer *timer)
+{
+	RB_LINK *rb_link = &queue->root.node;
+	struct rb_node *parent = NULL;
+	struct rb_node *node;
+	const struct rb_timer *cur;
+	int leftmost = 1;
+
+	while ((node = rb_link_get(rb_link))) {
+		cur = rb_entry(node, struct rb_timer, rb);
+		parent = node;
+
+		if (timer->expires < cur->expires) {
+			rb_link = &node->left;
+		} else {
+			rb_link = &node->right;
+			leftmost = 0;
+		}
+	}
+
+	rb_insert(&timer->rb, parent, rb_link, &queue->root);
+
+	if (leftmost)
+		queue->first = timer;
+}
+
+/**
+ * rb_timer_add() - Add timer to timer queue
+ * @queue: pointer to the timer queue
+ * @timer: timer which is not pending
+ * @expires: deadline of the timer
+ *
+ * The deadline is delayed by at most the slack of @queue when another timer
+ * with a later deadline is already pending. Both timers then expire together.
+ * The used deadline is stored in @timer->expires.
+ */
+void rb_timer_add(struct rb_timer_queue *queue, struct rb_timer *timer,
+		  uint64_t expires)
+{
+	timer->expires = rb_timer_coalesce(queue, expires);
+	rb_timer_link(queue, timer);
+}
+
+/**
+ * rb_timer_del() - Remove pending timer from timer queue
+ * @queue: pointer to the timer queue
+ * @timer: pending timer
+ */
+void rb_timer_del(struct rb_timer_queue *queue, struct rb_timer *timer)
+{
+	if (queue->first == timer)
+		queue->first = rb_timer_of(rb_erase_next(&timer->rb,
+							 &queue->root));
+	else
+		rb_erase(&timer->rb, &queue->root);
+}
+
+/**
+ * rb_timer_mod() - Change deadline of pending timer
+ * @queue: pointer to the timer queue
+ * @timer: pending timer
+ * @expires: new deadline of the timer
+ *
+ * The deadline is updated in place when the timer keeps its position
+ * relative to its neighbours. The timer is only removed and added again
+ * (with coalescing) when it has to move in the queue.
+ */
+void rb_timer_mod(struct rb_timer_queue *queue, struct rb_timer *timer,
+		  uint64_t expires)
+{
+	const struct rb_timer *prev = rb_timer_of(rb_prev(&timer->rb));
+	const struct rb_timer *next = rb_timer_of(rb_next(&timer->rb));
+
+	if ((!prev || prev->expires <= expires) &&
+	    (!next || next->expires > expires)) {
+		timer->expires = expires;
+		return;
+	}
+
+	rb_timer_del(queue, timer);
+	rb_timer_add(queue, timer, expires);
+}
+
+/**
+ * rb_timer_split_cmp() - Compare split pivot with timer
+ * @pivot: node of the pivot timer
+ * @node: node of a pending timer
+ *
+ * The result is never 0. All timers with the deadline of @pivot are
+ * therefore moved to the left (expired) tree by rb_split.
+ *
+ * Return: -1 when @pivot is earlier than @node, 1 otherwise
+ */
+static int rb_timer_split_cmp(const struct rb_node *pivot,
+			      const struct rb_node *node)
+{
+	const struct rb_timer *timer1 = rb_entry(pivot, struct rb_timer, rb);
+	const struct rb_timer *timer2 = rb_entry(node, struct rb_timer, rb);
+
+	return timer1->expires < timer2->expires ? -1 : 1;
+}
+
+/**
+ * rb_timer_expire() - Remove and run all expired timers
+ * @queue: pointer to the timer queue
+ * @now: current time
+ * @fn: function called for each timer with a deadline <= @now
+ * @arg: second argument for @fn
+ *
+ * All expired timers are detached with a single O(log(n)) rb_split instead
+ * of one rb_erase per timer. @fn is called in deadline order after the queue
+ * was updated. It can therefore add timers to @queue, re-add or free the
+ * expired timer. It must not access other expired timers.
+ *
+ * Return: number of expired timers
+ */
+size_t rb_timer_expire(struct rb_timer_queue *queue, uint64_t now,
+		       void (*fn)(struct rb_timer *timer, void *arg),
+		       void *arg)
+{
+	struct rb_node *stack[RB_TIMER_MAX_DEPTH];
+	struct rb_timer pivot;
+	struct rb_root expired;
+	struct rb_node *node;
+	struct rb_node *right;
+	size_t depth = 0;
+	size_t count = 0;
+
+	if (!queue->first || queue->first->expires > now)
+		return 0;
+
+	pivot.expires = now;
+	rb_split(&queue->root, &pivot.rb, rb_timer_split_cmp, &expired,
+		 &queue->root);
+
+	queue->first = rb_timer_of(rb_first(&queue->root));
+
+	/* in-order walk which doesn't access a node after @fn was called */
+	node = rb_link_get(&expired.node);
+	while (node || depth) {
+		while (node) {
+			stack[depth++] = node;
+			node = rb_left(node);
+		}
+
+		node = stack[--depth];
+		right = rb_right(node);
+
+		fn(rb_entry(node, struct rb_timer, rb), arg);
+		count++;
+
+		node = right;
+	}
+
+	return count;
+}
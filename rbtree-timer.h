@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: MIT */
+/* Minimal red-black-tree helper functions - timer queue
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#ifndef __RBTREE_TIMER_H__
+#define __RBTREE_TIMER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rbtree.h"
+
+/**
+ * struct rb_timer - timer in a timer queue
+ * @rb: node in the tree of the timer queue
+ * @expires: deadline of the timer
+ *
+ * The timer is usually embedded in the object which has to be notified on
+ * expiry. rb_entry can then be used to get the object from the timer.
+ */
+struct rb_timer {
+	struct rb_node rb;
+	uint64_t expires;
+};
+
+/**
+ * struct rb_timer_queue - queue of pending timers sorted by deadline
+ * @root: tree of the pending timers
+ * @first: pending timer with the earliest deadline, NULL when queue is empty
+ * @slack: maximum delay which a timer can get to share the deadline of an
+ *  already pending timer
+ *
+ * Timers with the same deadline expire in the order they were added.
+ */
+struct rb_timer_queue {
+	struct rb_root root;
+	struct rb_timer *first;
+	uint64_t slack;
+};
+
+/**
+ * rb_timer_peek() - Get pending timer with the earliest deadline
+ * @queue: pointer to the timer queue
+ *
+ * Return: timer with the earliest deadline, NULL when no timer is pending
+ */
+static __inline__ struct rb_timer *
+rb_timer_peek(const struct rb_timer_queue *queue)
+{
+	return queue->first;
+}
+
+void rb_timer_queue_init(struct rb_timer_queue *queue, uint64_t slack);
+void rb_timer_add(struct rb_timer_queue *queue, struct rb_timer *timer,
+		  uint64_t expires);
+void rb_timer_del(struct rb_timer_queue *queue, struct rb_timer *timer);
+void rb_timer_mod(struct rb_timer_queue *queue, struct rb_timer *timer,
+		  uint64_t expires);
+size_t rb_timer_expire(struct rb_timer_queue *queue, uint64_t now,
+		       void (*fn)(struct rb_timer *timer, void *arg),
+		       void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RBTREE_TIMER_H__ */
@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions - lazy deletion
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include "rbtree-tombstone.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/**
+ * rb_tomb_live() - Skip tombstones in tree order
+ * @node: first node to check, can be NULL
+ * @forward: search via rb_next when not 0, otherwise via rb_prev
+ *
+ * Return: first live entry starting at @node, NULL when none was found
+ */
+static struct rb_tnode *rb_tomb_live(struct rb_node *node, int forward)
+{
+	struct rb_tnode *tnode;
+
+	while (node) {
+		tnode = rb_entry(node, struct rb_tnode, rb);
+		if (!tnode->dead)
+			return tnode;
+
+		if (forward)
+			node = rb_next(node);
+		else
+			node = rb_prev(node);
+	}
+
+	return NULL;
+}
+
+/**
+ * rb_tomb_init() - Initialize empty tree with lazy deletion
+ * @troot: pointer to the tombstone root
+ * @threshold: percentage of tombstones at which rb_tomb_erase requests a
+ *  compaction
+ */
+void rb_tomb_init(struct rb_troot *troot, unsigned int threshold)
+{
+	INIT_RB_ROOT(&troot->root);
+	troot->live = 0;
+	troot->dead = 0;
+	troot->threshold = threshold;
+}
+
+/**
+ * rb_tomb_insert() - Add live entry to tree
+ * @troot: pointer to the tombstone root
+ * @tnode: pointer to the new entry
+ * @cmp: comparison function which returns <0, 0 or >0 when first node is
+ *  smaller, equal or larger than the second node
+ *
+ * The entry is inserted after all entries (live or dead) with the same key.
+ */
+void rb_tomb_insert(struct rb_troot *troot, struct rb_tnode *tnode,
+		    int (*cmp)(const struct rb_node *node1,
+			       const struct rb_node *node2))
+{
+	RB_LINK *rb_link = &troot->root.node;
+	struct rb_node *parent = NULL;
+	struct rb_node *node;
+
+	while ((node = rb_link_get(rb_link))) {
+		parent = node;
+
+		if (cmp(&tnode->rb, node) < 0)
+			rb_link = &node->left;
+		else
+			rb_link = &node->right;
+	}
+
+	tnode->dead = 0;
+	rb_insert(&tnode->rb, parent, rb_link, &troot->root);
+	troot->live++;
+}
+
+/**
+ * rb_tomb_erase() - Mark live entry as erased
+ * @troot: pointer to the tombstone root
+ * @tnode: pointer to the live entry
+ *
+ * The entry stays in the tree as tombstone and the tree is not rebalanced.
+ * The tombstone is removed (and can be free'd) after the next
+ * rb_tomb_compact.
+ *
+ * Return: 1 when the ratio of tombstones reached the threshold and
+ *  rb_tomb_compact should be called, 0 otherwise
+ */
+int rb_tomb_erase(struct rb_troot *troot, struct rb_tnode *tnode)
+{
+	size_t total;
+
+	tnode->dead = 1;
+	troot->live--;
+	troot->dead++;
+
+	total = troot->live + troot->dead;
+
+	return troot->dead * 100 >= total * troot->threshold;
+}
+
+/**
+ * rb_tomb_find() - Find live entry with key
+ * @troot: pointer to the tombstone root
+ * @key: pointer to the key to search for
+ * @cmp: comparison function which returns <0, 0 or >0 when @key is smaller,
+ *  equal or larger than the node
+ *
+ * Return: first live entry which is equal to @key, NULL when no such entry
+ *  exists
+ */
+struct rb_tnode *rb_tomb_find(const struct rb_troot *troot, const void *key,
+			      int (*cmp)(const void *key,
+					 const struct rb_node *node))
+{
+	struct rb_node *node = rb_link_get(&troot->root.node);
+	struct rb_node *found = NULL;
+	struct rb_tnode *tnode;
+	int res;
+
+	/* search first (maybe dead) entry with the key */
+	while (node) {
+		res = cmp(key, node);
+		if (res <= 0) {
+			if (res == 0)
+				found = node;
+
+			node = rb_left(node);
+		} else {
+			node = rb_right(node);
+		}
+	}
+
+	/* skip tombstones with the same key */
+	while (found) {
+		tnode = rb_entry(found, struct rb_tnode, rb);
+		if (!tnode->dead)
+			return tnode;
+
+		found = rb_next(found);
+		if (found && cmp(key, found) != 0)
+			found = NULL;
+	}
+
+	return NULL;
+}
+
+/**
+ * rb_tomb_compact() - Remove all tombstones from tree
+ * @troot: pointer to the tombstone root
+ * @drop: function called for each removed tombstone, can be NULL
+ * @arg: second argument for @drop
+ *
+ * The tree is rebuilt in O(n) via rb_build from the live entries. @drop is
+ * called after the tree was rebuilt and can free the tombstones.
+ *
+ * Return: 0 on success, -ENOMEM when no memory for the rebuild was available.
+ *  The tree is unchanged in this case
+ */
+int rb_tomb_compact(struct rb_troot *troot,
+		    void (*drop)(struct rb_tnode *tnode, void *arg),
+		    void *arg)
+{
+	size_t total = troot->live + troot->dead;
+	struct rb_node **nodes;
+	struct rb_node *node;
+	struct rb_tnode *tnode;
+	size_t live = 0;
+	size_t dead = total;
+	size_t i;
+
+	if (!troot->dead)
+		return 0;
+
+	nodes = (struct rb_node **)malloc(total * sizeof(*nodes));
+	if (!nodes)
+		return -ENOMEM;
+
+	/* live entries from the front, tombstones from the back */
+	for (node = rb_first(&troot->root); node; node = rb_next(node)) {
+		tnode = rb_entry(node, struct rb_tnode, rb);
+		if (tnode->dead)
+			nodes[--dead] = node;
+		else
+			nodes[live++] = node;
+	}
+
+	rb_build(&troot->root, nodes, live);
+	troot->dead = 0;
+
+	if (drop) {
+		for (i = total; i > dead; i--)
+			drop(rb_entry(nodes[i - 1], struct rb_tnode, rb), arg);
+	}
+
+	free(nodes);
+
+	return 0;
+}
+
+/**
+ * rb_tomb_first() - Find first live entry in tree
+ * @troot: pointer to the tombstone root
+ *
+ * Return: pointer to first live entry. NULL when no live entry exists
+ */
+struct rb_tnode *rb_tomb_first(const struct rb_troot *troot)
+{
+	return rb_tomb_live(rb_first(&troot->root), 1);
+}
+
+/**
+ * rb_tomb_last() - Find last live entry in tree
+ * @troot: pointer to the tombstone root
+ *
+ * Return: pointer to last live entry. NULL when no live entry exists
+ */
+struct rb_tnode *rb_tomb_last(const struct rb_troot *troot)
+{
+	return rb_tomb_live(rb_last(&troot->root), 0);
+}
+
+/**
+ * rb_tomb_next() - Find live successor of entry
+ * @tnode: starting entry for search, can be a tombstone
+ *
+ * Return: pointer to next live entry. NULL when no live successor exists
+ */
+struct rb_tnode *rb_tomb_next(struct rb_tnode *tnode)
+{
+	return rb_tomb_live(rb_next(&tnode->rb), 1);
+}
+
+/**
+ * rb_tomb_prev() - Find live predecessor of entry
+ * @tnode: starting entry for search, can be a tombstone
+ *
+ * Return: pointer to previous live entry. NULL when no live predecessor
+ *  exists
+ */
+struct rb_tnode *rb_tomb_prev(struct rb_tnode *tnode)
+{
+	return rb_tomb_live(rb_prev(&tnode->rb), 0);
+}
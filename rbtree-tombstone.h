@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: MIT */
+/* Minimal red-black-tree helper functions - lazy deletion
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#ifndef __RBTREE_TOMBSTONE_H__
+#define __RBTREE_TOMBSTONE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "rbtree.h"
+
+/**
+ * struct rb_tnode - node of a red-black tree with lazy deletion
+ * @rb: node in the tree
+ * @dead: entry was erased and is only kept as tombstone in the tree
+ */
+struct rb_tnode {
+	struct rb_node rb;
+	unsigned char dead;
+};
+
+/**
+ * struct rb_troot - root of a red-black tree with lazy deletion
+ * @root: tree of live entries and tombstones
+ * @live: number of live entries in @root
+ * @dead: number of tombstones in @root
+ * @threshold: percentage of tombstones in @root at which a compaction is
+ *  requested
+ */
+struct rb_troot {
+	struct rb_root root;
+	size_t live;
+	size_t dead;
+	unsigned int threshold;
+};
+
+void rb_tomb_init(struct rb_troot *troot, unsigned int threshold);
+void rb_tomb_insert(struct rb_troot *troot, struct rb_tnode *tnode,
+		    int (*cmp)(const struct rb_node *node1,
+			       const struct rb_node *node2));
+int rb_tomb_erase(struct rb_troot *troot, struct rb_tnode *tnode);
+struct rb_tnode *rb_tomb_find(const struct rb_troot *troot, const void *key,
+			      int (*cmp)(const void *key,
+					 const struct rb_node *node));
+int rb_tomb_compact(struct rb_troot *troot,
+		    void (*drop)(struct rb_tnode *tnode, void *arg),
+		    void *arg);
+
+struct rb_tnode *rb_tomb_first(const struct rb_troot *troot);
+struct rb_tnode *rb_tomb_last(const struct rb_troot *troot);
+struct rb_tnode *rb_tomb_next(struct rb_tnode *tnode);
+struct rb_tnode *rb_tomb_prev(struct rb_tnode *tnode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RBTREE_TOMBSTONE_H__ */
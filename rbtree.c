@@ -4,9 +4,178 @@
  * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
  */
 
+#if defined(RB_TRACE) && !defined(_POSIX_C_SOURCE)
+/* required for clock_gettime */
+#define _POSIX_C_SOURCE 199309L
+#endif
+
 #include "rbtree.h"
 
 #include <stddef.h>
+#include <string.h>
+
+#ifdef RB_TRACE
+#include <time.h>
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define rb_probe(name, arg) DTRACE_PROBE1(rbtree, name, arg)
+#endif
+#endif
+#endif
+
+#ifndef rb_probe
+#define rb_probe(name, arg) do { } while (0)
+#endif
+
+/* number of lookups which are processed in lock-step by batched searches */
+#define RB_BATCH_GROUP 16
+
+#if defined(__GNUC__)
+#define rb_prefetch(ptr) __builtin_prefetch(ptr)
+#else
+#define rb_prefetch(ptr) do { } while (0)
+#endif
+
+#if defined(__GNUC__)
+#define RB_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define RB_THREAD_LOCAL __declspec(thread)
+#else
+#define RB_THREAD_LOCAL
+#endif
+
+#ifdef RB_STATS
+/* operation counters of the current thread */
+static RB_THREAD_LOCAL struct rb_stats rb_stats_local;
+
+#define rb_stat_inc(field) (rb_stats_local.field++)
+#else
+#define rb_stat_inc(field) do { } while (0)
+#endif
+
+#ifdef RB_TRACE
+/* number of linear sub-buckets per power of two */
+#define RB_LATENCY_SUB_BITS 3
+#define RB_LATENCY_SUB_BUCKETS (1lu << RB_LATENCY_SUB_BITS)
+
+/**
+ * struct rb_trace_state - latency sampling state of a thread
+ * @countdown: number of operations until the next sample
+ * @active: current operation is sampled
+ * @start: start time of the sampled operation
+ * @hist: latency histograms for each operation
+ *
+ * The traced functions never call each other. Only a single operation can
+ * therefore be sampled at a time by a thread.
+ */
+struct rb_trace_state {
+	unsigned int countdown;
+	int active;
+	struct timespec start;
+	struct rb_latency_hist hist[RB_TRACE_OP_COUNT];
+};
+
+static RB_THREAD_LOCAL struct rb_trace_state rb_trace_local;
+static unsigned int rb_trace_sample_rate = RB_TRACE_SAMPLE_RATE;
+
+/**
+ * rb_latency_bucket() - Get histogram bucket for latency
+ * @ns: latency in nanoseconds
+ *
+ * Small values have their own bucket. Larger values are sorted in power of two
+ * ranges which are split again in RB_LATENCY_SUB_BUCKETS linear buckets. The
+ * relative error stays therefore below 1/RB_LATENCY_SUB_BUCKETS.
+ *
+ * Return: index of the bucket for @ns
+ */
+static size_t rb_latency_bucket(unsigned long ns)
+{
+	unsigned long tmp = ns;
+	size_t msb = 0;
+
+	if (ns < 2 * RB_LATENCY_SUB_BUCKETS)
+		return ns;
+
+	while (tmp >>= 1)
+		msb++;
+
+	return (msb - RB_LATENCY_SUB_BITS + 1) * RB_LATENCY_SUB_BUCKETS +
+	       ((ns >> (msb - RB_LATENCY_SUB_BITS)) &
+		(RB_LATENCY_SUB_BUCKETS - 1));
+}
+
+/**
+ * rb_trace_start() - Start latency sample of operation when selected
+ */
+static void rb_trace_start(void)
+{
+	rb_trace_local.active = 0;
+
+	if (rb_trace_local.countdown > 1) {
+		rb_trace_local.countdown--;
+		return;
+	}
+
+	rb_trace_local.countdown = rb_trace_sample_rate;
+	rb_trace_local.active = 1;
+	clock_gettime(CLOCK_MONOTONIC, &rb_trace_local.start);
+}
+
+/**
+ * rb_trace_stop() - Finish latency sample of operation
+ * @op: type of the operation
+ */
+static void rb_trace_stop(enum rb_trace_op op)
+{
+	struct timespec end;
+	unsigned long ns;
+
+	if (!rb_trace_local.active)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	ns = (unsigned long)(end.tv_sec - rb_trace_local.start.tv_sec) *
+	     1000000000lu;
+	ns += (unsigned long)end.tv_nsec;
+	ns -= (unsigned long)rb_trace_local.start.tv_nsec;
+
+	rb_trace_local.hist[op].count[rb_latency_bucket(ns)]++;
+}
+
+#define rb_trace_enter(name, arg) \
+	do { \
+		rb_probe(name ## _entry, arg); \
+		rb_trace_start(); \
+	} while (0)
+#define rb_trace_exit(name, op, arg) \
+	do { \
+		rb_trace_stop(op); \
+		rb_probe(name ## _exit, arg); \
+	} while (0)
+#else
+#define rb_trace_enter(name, arg) do { } while (0)
+#define rb_trace_exit(name, op, arg) do { } while (0)
+#endif
+
+#ifdef RB_RELATIVE_POINTERS
+/**
+ * rb_parent_offset() - Get offset from node to its parent
+ * @node: pointer to the rb node
+ * @parent: pointer to the parent node, can be NULL
+ *
+ * Return: offset from @node to @parent, 0 when @parent is NULL
+ */
+static ptrdiff_t rb_parent_offset(struct rb_node *node,
+				  struct rb_node *parent)
+{
+	if (!parent)
+		return 0;
+
+	return (char *)parent - (char *)node;
+}
+#endif
 
 /**
  * rb_set_parent() - Set parent of node
@@ -15,7 +184,10 @@
  */
 static void rb_set_parent(struct rb_node *node, struct rb_node *parent)
 {
-#ifndef RB_PARENT_COLOR_COMBINATION
+#if defined(RB_RELATIVE_POINTERS)
+	node->parent_color = rb_parent_offset(node, parent) |
+			     (node->parent_color & 1);
+#elif !defined(RB_PARENT_COLOR_COMBINATION)
 	node->parent = parent;
 #else
 	node->parent_color = (unsigned long)parent | (node->parent_color & 1lu);
@@ -29,7 +201,9 @@ static void rb_set_parent(struct rb_node *node, struct rb_node *parent)
  */
 static void rb_set_color(struct rb_node *node, enum rb_node_color color)
 {
-#ifndef RB_PARENT_COLOR_COMBINATION
+#if defined(RB_RELATIVE_POINTERS)
+	node->parent_color = (node->parent_color & ~(ptrdiff_t)1) | color;
+#elif !defined(RB_PARENT_COLOR_COMBINATION)
 	node->color = color;
 #else
 	node->parent_color = (node->parent_color & ~1lu) | color;
@@ -45,7 +219,9 @@ static void rb_set_color(struct rb_node *node, enum rb_node_color color)
 static void rb_set_parent_color(struct rb_node *node, struct rb_node *parent,
 				enum rb_node_color color)
 {
-#ifndef RB_PARENT_COLOR_COMBINATION
+#if defined(RB_RELATIVE_POINTERS)
+	node->parent_color = rb_parent_offset(node, parent) | color;
+#elif !defined(RB_PARENT_COLOR_COMBINATION)
 	node->parent = parent;
 	node->color = color;
 #else
@@ -86,15 +262,70 @@ static void rb_change_child(struct rb_node *old_node, struct rb_node *new_node,
 			    struct rb_node *parent, struct rb_root *root)
 {
 	if (parent) {
-		if (parent->left == old_node)
-			parent->left = new_node;
+		if (rb_left(parent) == old_node)
+			rb_link_set(&parent->left, new_node);
 		else
-			parent->right = new_node;
+			rb_link_set(&parent->right, new_node);
 	} else {
-		root->node = new_node;
+		rb_link_set(&root->node, new_node);
 	}
 }
 
+/**
+ * rb_relink_node() - Let node take over position in tree
+ * @old_node: rb node which was at the position in the tree
+ * @new_node: rb node which should take over the position
+ * @parent: parent of @old_node
+ * @color: color of @old_node
+ * @left: left child of @old_node
+ * @right: right child of @old_node
+ * @root: pointer to rb root
+ *
+ * The links of @new_node are initialized with the given values. The parent
+ * and the children are then updated to point to @new_node. @old_node itself
+ * is not accessed.
+ */
+static void rb_relink_node(struct rb_node *old_node, struct rb_node *new_node,
+			   struct rb_node *parent, enum rb_node_color color,
+			   struct rb_node *left, struct rb_node *right,
+			   struct rb_root *root)
+{
+	rb_set_parent_color(new_node, parent, color);
+	rb_link_set(&new_node->left, left);
+	rb_link_set(&new_node->right, right);
+
+	if (left)
+		rb_set_parent(left, new_node);
+	if (right)
+		rb_set_parent(right, new_node);
+
+	rb_change_child(old_node, new_node, parent, root);
+}
+
+/**
+ * rb_replace_node() - Let node take over position of another node in tree
+ * @old_node: rb node in the tree
+ * @new_node: rb node which is not part of the tree
+ * @root: pointer to rb root
+ *
+ * The color and links of @old_node are copied to @new_node. The parent and
+ * the children of @old_node are then updated to point to @new_node. No
+ * rebalancing is done and the runtime is therefore O(1).
+ *
+ * The entry of @new_node must be sorted at the same position as the entry of
+ * @old_node. @old_node is afterwards no longer part of the tree and must be
+ * valid until this function returns. It can be used to swap in an updated
+ * copy of an entry or to move an entry to a different memory location.
+ */
+RBTREE_API
+void rb_replace_node(struct rb_node *old_node, struct rb_node *new_node,
+		     struct rb_root *root)
+{
+	rb_relink_node(old_node, new_node, rb_parent(old_node),
+		       rb_color(old_node), rb_left(old_node),
+		       rb_right(old_node), root);
+}
+
 /**
  * rb_rotate_switch_parents() - set parent for switched nodes after rotate
  * @node_top: rb node which became the new top node
@@ -139,53 +370,64 @@ static void rb_rotate_switch_parents(struct rb_node *node_top,
  *
  * When the tree was a LLRB before the link of the new node then the resulting
  * tree will again be a LLRB tree
+ *
+ * Return: 1 when the black height of the tree increased, 0 otherwise
  */
-static void rb_insert_color(struct rb_node *node, struct rb_root *root)
+static int rb_insert_color(struct rb_node *node, struct rb_root *root)
 {
 	struct rb_node *parent;
 	struct rb_node *tmp;
 
 	/* go tree upwards and fix the nodes on the way */
 	while (node) {
+		rb_stat_inc(insert_path);
 		parent = rb_parent(node);
 
-		if (!rb_is_red(node->left)) {
+		if (!rb_is_red(rb_left(node))) {
 			/* rotate 3-node to left when right child is red */
-			if (rb_is_red(node->right)) {
-				tmp = node->right;
-				node->right = tmp->left;
-				tmp->left = node;
+			if (rb_is_red(rb_right(node))) {
+				rb_stat_inc(insert_rotate_left);
+
+				tmp = rb_right(node);
+				rb_link_set(&node->right, rb_left(tmp));
+				rb_link_set(&tmp->left, node);
 
 				/* fix colors and parent entries
 				 * node must become red during rotate
 				 */
-				rb_rotate_switch_parents(tmp, node, node->right,
-							 root, RB_RED);
+				rb_rotate_switch_parents(tmp, node,
+							 rb_right(node), root,
+							 RB_RED);
 
 				node = tmp;
 			}
 		} else {
 			/* rotate right when two consecutive left nodes are red
 			 */
-			if (rb_is_red(node->left->left)) {
-				tmp = node->left;
-				node->left = tmp->right;
-				tmp->right = node;
+			if (rb_is_red(rb_left(rb_left(node)))) {
+				rb_stat_inc(insert_rotate_right);
+
+				tmp = rb_left(node);
+				rb_link_set(&node->left, rb_right(tmp));
+				rb_link_set(&tmp->right, node);
 
 				/* fix colors and parent entries
 				 * node must become red during rotate
 				 */
-				rb_rotate_switch_parents(tmp, node, node->left,
-							 root, RB_RED);
+				rb_rotate_switch_parents(tmp, node,
+							 rb_left(node), root,
+							 RB_RED);
 
 				node = tmp;
 			}
 
 			/* flip color/split 4-node into 2-nodes */
-			if (rb_is_red(node->right)) {
+			if (rb_is_red(rb_right(node))) {
+				rb_stat_inc(insert_color_flip);
+
 				rb_set_color(node, RB_RED);
-				rb_set_color(node->left, RB_BLACK);
-				rb_set_color(node->right, RB_BLACK);
+				rb_set_color(rb_left(node), RB_BLACK);
+				rb_set_color(rb_right(node), RB_BLACK);
 			}
 		}
 
@@ -194,11 +436,15 @@ static void rb_insert_color(struct rb_node *node, struct rb_root *root)
 			break;
 
 		/* reached red root, mark it black */
-		if (!parent)
+		if (!parent) {
 			rb_set_parent_color(node, NULL, RB_BLACK);
+			return 1;
+		}
 
 		node = parent;
 	}
+
+	return 0;
 }
 
 /**
@@ -217,13 +463,13 @@ static void rb_insert_color(struct rb_node *node, struct rb_root *root)
  * can be used as helper to run both steps at the same time.
  */
 static void rb_link_node(struct rb_node *node, struct rb_node *parent,
-			 struct rb_node **rb_link)
+			 RB_LINK *rb_link)
 {
 	rb_set_parent_color(node, parent, RB_RED);
-	node->left = NULL;
-	node->right = NULL;
+	rb_link_set(&node->left, NULL);
+	rb_link_set(&node->right, NULL);
 
-	*rb_link = node;
+	rb_link_set(rb_link, node);
 }
 
 /**
@@ -233,11 +479,477 @@ static void rb_link_node(struct rb_node *node, struct rb_node *parent,
  * @rb_link: pointer to the left/right pointer of @parent
  * @root: pointer to rb root
  */
+RBTREE_API
 void rb_insert(struct rb_node *node, struct rb_node *parent,
-	       struct rb_node **rb_link, struct rb_root *root)
+	       RB_LINK *rb_link, struct rb_root *root)
 {
+	rb_trace_enter(insert, node);
+	rb_stat_inc(insert);
+
 	rb_link_node(node, parent, rb_link);
 	rb_insert_color(node, root);
+
+	rb_trace_exit(insert, RB_TRACE_INSERT, node);
+}
+
+/**
+ * rb_insert_hint() - Add new node next to hint node and rebalance tree
+ * @node: pointer to the new node
+ * @hint: pointer to a node of the tree which is expected to become an in-order
+ *  neighbor of @node. Can be NULL
+ * @root: pointer to rb root
+ * @cmp: comparison function which returns <0, 0 or >0 when first node is
+ *  smaller, equal or larger than the second node
+ *
+ * The link slot for @node is searched locally around @hint. It is only checked
+ * whether @node belongs between @hint and its successor or between @hint and
+ * its predecessor. The free link slot is then either the child pointer of
+ * @hint or of the neighbor. A full descent from the root is only done when
+ * @hint was wrong.
+ *
+ * Nodes which compare equal to @node are kept in insertion order - @node is
+ * always inserted after them.
+ *
+ * The most recently inserted node is a good @hint for (nearly) sorted input.
+ * At most two comparisons are required per insert in this case. The search
+ * for the successor or predecessor of @hint is still O(log(n)): without a
+ * child on that side, it climbs to the first ancestor in that direction. For
+ * appends after the last node (or prepends before the first node), it climbs
+ * the whole spine up to the root. Only the comparisons of the descent are
+ * saved, the pointer walk has the same length. The gain therefore depends on
+ * the costs of @cmp.
+ */
+RBTREE_API
+void rb_insert_hint(struct rb_node *node, struct rb_node *hint,
+		    struct rb_root *root,
+		    int (*cmp)(const struct rb_node *node1,
+			       const struct rb_node *node2))
+{
+	struct rb_node *parent = NULL;
+	RB_LINK *rb_link = &root->node;
+	struct rb_node *neighbor;
+
+	if (hint) {
+		if (cmp(node, hint) >= 0) {
+			/* must be between hint and its successor */
+			neighbor = rb_next(hint);
+			if (!neighbor || cmp(node, neighbor) < 0) {
+				/* successor is leftmost node of right subtree
+				 * when hint has a right child
+				 */
+				if (!rb_right(hint)) {
+					parent = hint;
+					rb_link = &hint->right;
+				} else {
+					parent = neighbor;
+					rb_link = &neighbor->left;
+				}
+
+				rb_insert(node, parent, rb_link, root);
+				return;
+			}
+		} else {
+			/* must be between predecessor and hint */
+			neighbor = rb_prev(hint);
+			if (!neighbor || cmp(node, neighbor) >= 0) {
+				/* predecessor is rightmost node of left subtree
+				 * when hint has a left child
+				 */
+				if (!rb_left(hint)) {
+					parent = hint;
+					rb_link = &hint->left;
+				} else {
+					parent = neighbor;
+					rb_link = &neighbor->right;
+				}
+
+				rb_insert(node, parent, rb_link, root);
+				return;
+			}
+		}
+	}
+
+	/* hint was wrong, fall back to descent from the root */
+	while (rb_link_get(rb_link)) {
+		parent = rb_link_get(rb_link);
+
+		if (cmp(node, parent) < 0)
+			rb_link = &parent->left;
+		else
+			rb_link = &parent->right;
+	}
+
+	rb_insert(node, parent, rb_link, root);
+}
+
+/**
+ * rb_build_subtree() - Build LLRB subtree from sorted nodes
+ * @nodes: sorted array of nodes
+ * @count: number of entries in @nodes
+ * @height: black height of the new subtree
+ * @caps: maximum number of nodes for each black height
+ * @parent: parent of the new subtree
+ *
+ * The subtree is build like a 2-3 tree with equal black height for all
+ * leaves. The nodes are split in a 2-node with two or a 3-node (black node
+ * with red left child) with three subtrees of nearly equal size. A 3-node is
+ * only used when the subtrees of a 2-node would exceed @caps[@height - 1].
+ *
+ * @count must be between 2^@height - 1 and @caps[@height].
+ *
+ * Return: root of the new subtree, NULL when @count is 0
+ */
+static struct rb_node *rb_build_subtree(struct rb_node * const *nodes,
+					size_t count, unsigned int height,
+					const size_t *caps,
+					struct rb_node *parent)
+{
+	size_t left, middle, right;
+	struct rb_node *black;
+	struct rb_node *red;
+	struct rb_node *child;
+
+	if (!count)
+		return NULL;
+
+	right = (count - 1) / 2;
+	left = count - 1 - right;
+
+	if (left <= caps[height - 1]) {
+		/* 2-node */
+		black = nodes[left];
+		rb_set_parent_color(black, parent, RB_BLACK);
+		child = rb_build_subtree(nodes, left, height - 1, caps, black);
+		rb_link_set(&black->left, child);
+		child = rb_build_subtree(&nodes[left + 1], right, height - 1,
+					 caps, black);
+		rb_link_set(&black->right, child);
+		return black;
+	}
+
+	/* 3-node */
+	right = (count - 2) / 3;
+	middle = (count - 1) / 3;
+	left = count - 2 - middle - right;
+
+	red = nodes[left];
+	black = nodes[left + 1 + middle];
+
+	rb_set_parent_color(black, parent, RB_BLACK);
+	rb_set_parent_color(red, black, RB_RED);
+	rb_link_set(&black->left, red);
+	child = rb_build_subtree(nodes, left, height - 1, caps, red);
+	rb_link_set(&red->left, child);
+	child = rb_build_subtree(&nodes[left + 1], middle, height - 1, caps,
+				 red);
+	rb_link_set(&red->right, child);
+	child = rb_build_subtree(&nodes[left + middle + 2], right, height - 1,
+				 caps, black);
+	rb_link_set(&black->right, child);
+
+	return black;
+}
+
+/**
+ * rb_build() - Replace tree with balanced tree of sorted nodes
+ * @root: pointer to rb root
+ * @nodes: array of nodes in ascending order
+ * @count: number of entries in @nodes
+ *
+ * All nodes in @root are dropped (not modified) and the tree is rebuilt in
+ * O(@count) from @nodes without any comparison. The nodes must already be
+ * sorted as expected by later lookups. The resulting tree is a valid LLRB
+ * with the minimal black height for @count nodes.
+ */
+RBTREE_API
+void rb_build(struct rb_root *root, struct rb_node * const *nodes,
+	      size_t count)
+{
+	size_t caps[sizeof(size_t) * 8];
+	unsigned int height = 0;
+	size_t tmp;
+
+	/* minimal black height: 2^height - 1 <= count */
+	for (tmp = count + 1; tmp > 1; tmp >>= 1)
+		height++;
+
+	/* 3^h - 1 nodes fit in a 2-3 tree with black height h */
+	caps[0] = 0;
+	for (tmp = 1; tmp <= height; tmp++) {
+		if (caps[tmp - 1] > ((size_t)-1 - 2) / 3)
+			caps[tmp] = (size_t)-1;
+		else
+			caps[tmp] = caps[tmp - 1] * 3 + 2;
+	}
+
+	rb_link_set(&root->node,
+		    rb_build_subtree(nodes, count, height, caps, NULL));
+}
+
+/**
+ * rb_black_height() - Get number of black nodes on the path to a leaf
+ * @node: root of the subtree
+ *
+ * Return: black height of @node
+ */
+static unsigned int rb_black_height(const struct rb_node *node)
+{
+	unsigned int height = 0;
+
+	for (; node; node = rb_left(node)) {
+		if (rb_color(node) == RB_BLACK)
+			height++;
+	}
+
+	return height;
+}
+
+/**
+ * rb_detach_subtree() - Convert subtree into standalone tree
+ * @node: root of the subtree, can be NULL
+ * @height: black height of @node, is increased when @node becomes black
+ *
+ * Return: @node
+ */
+static struct rb_node *rb_detach_subtree(struct rb_node *node,
+					 unsigned int *height)
+{
+	if (!node)
+		return NULL;
+
+	if (rb_color(node) == RB_RED)
+		(*height)++;
+
+	rb_set_parent_color(node, NULL, RB_BLACK);
+
+	return node;
+}
+
+/**
+ * rb_join_height() - Join two trees with known black height
+ * @root: pointer to rb root for the result
+ * @left: black root of tree with nodes smaller than @node
+ * @left_height: black height of @left
+ * @node: node between both trees
+ * @right: black root of tree with nodes larger than @node
+ * @right_height: black height of @right
+ *
+ * @node is linked as red node into the larger tree at the position on its
+ * right (left) spine where the black height matches the smaller tree. The
+ * smaller tree becomes the other child of @node. The tree is then fixed like
+ * after an insert of @node.
+ *
+ * Return: black height of the joined tree
+ */
+static unsigned int rb_join_height(struct rb_root *root, struct rb_node *left,
+				   unsigned int left_height,
+				   struct rb_node *node, struct rb_node *right,
+				   unsigned int right_height)
+{
+	struct rb_node *parent = NULL;
+	struct rb_node *child;
+	RB_LINK *rb_link;
+	unsigned int height;
+
+	if (left_height == right_height) {
+		rb_set_parent_color(node, NULL, RB_BLACK);
+		rb_link_set(&node->left, left);
+		rb_link_set(&node->right, right);
+		if (left)
+			rb_set_parent(left, node);
+		if (right)
+			rb_set_parent(right, node);
+
+		rb_link_set(&root->node, node);
+		return left_height + 1;
+	}
+
+	if (left_height > right_height) {
+		rb_link_set(&root->node, left);
+		rb_link = &root->node;
+		height = left_height;
+
+		child = left;
+		while (child && (rb_color(child) == RB_RED ||
+				 height > right_height)) {
+			if (rb_color(child) == RB_BLACK)
+				height--;
+
+			parent = child;
+			rb_link = &parent->right;
+			child = rb_right(parent);
+		}
+
+		rb_link_set(&node->left, child);
+		rb_link_set(&node->right, right);
+		height = left_height;
+	} else {
+		rb_link_set(&root->node, right);
+		rb_link = &root->node;
+		height = right_height;
+
+		child = right;
+		while (child && (rb_color(child) == RB_RED ||
+				 height > left_height)) {
+			if (rb_color(child) == RB_BLACK)
+				height--;
+
+			parent = child;
+			rb_link = &parent->left;
+			child = rb_left(parent);
+		}
+
+		rb_link_set(&node->left, left);
+		rb_link_set(&node->right, child);
+		height = right_height;
+	}
+
+	rb_set_parent_color(node, parent, RB_RED);
+	if (rb_left(node))
+		rb_set_parent(rb_left(node), node);
+	if (rb_right(node))
+		rb_set_parent(rb_right(node), node);
+	rb_link_set(rb_link, node);
+
+	return height + rb_insert_color(node, root);
+}
+
+/**
+ * rb_join() - Join two trees and a node between them
+ * @root: pointer to rb root for the result, can be @left or @right
+ * @left: pointer to rb root of the tree with nodes smaller than @node
+ * @node: pointer to the new node
+ * @right: pointer to rb root of the tree with nodes larger than @node
+ *
+ * All nodes in @left must be smaller and all nodes in @right must be larger
+ * than @node. @left and @right are empty afterwards (unless used as @root).
+ *
+ * The runtime is O(log(n)) and doesn't depend on the number of nodes in the
+ * smaller tree. No comparison is necessary.
+ */
+RBTREE_API
+void rb_join(struct rb_root *root, struct rb_root *left, struct rb_node *node,
+	     struct rb_root *right)
+{
+	struct rb_node *left_node = rb_link_get(&left->node);
+	struct rb_node *right_node = rb_link_get(&right->node);
+
+	rb_link_set(&left->node, NULL);
+	rb_link_set(&right->node, NULL);
+
+	rb_join_height(root, left_node, rb_black_height(left_node), node,
+		       right_node, rb_black_height(right_node));
+}
+
+/**
+ * rb_split_height() - Split subtree with known black height
+ * @node: black root of the subtree
+ * @height: black height of @node
+ * @pivot: node to split at
+ * @cmp: comparison function for two nodes
+ * @left: pointer to rb root for nodes smaller than @pivot
+ * @left_height: returns black height of @left
+ * @right: pointer to rb root for nodes larger than @pivot
+ * @right_height: returns black height of @right
+ *
+ * Return: node which is equal to @pivot, NULL when no such node exists
+ */
+static struct rb_node *rb_split_height(struct rb_node *node,
+				       unsigned int height,
+				       const struct rb_node *pivot,
+				       int (*cmp)(const struct rb_node *node1,
+						  const struct rb_node *node2),
+				       struct rb_root *left,
+				       unsigned int *left_height,
+				       struct rb_root *right,
+				       unsigned int *right_height)
+{
+	struct rb_node *found;
+	struct rb_node *child_left;
+	struct rb_node *child_right;
+	unsigned int height_left = height - 1;
+	unsigned int height_right = height - 1;
+	struct rb_root tmp;
+	unsigned int tmp_height;
+	int res;
+
+	if (!node) {
+		rb_link_set(&left->node, NULL);
+		*left_height = 0;
+		rb_link_set(&right->node, NULL);
+		*right_height = 0;
+		return NULL;
+	}
+
+	child_left = rb_detach_subtree(rb_left(node), &height_left);
+	child_right = rb_detach_subtree(rb_right(node), &height_right);
+
+	res = cmp(pivot, node);
+	if (res == 0) {
+		rb_link_set(&left->node, child_left);
+		*left_height = height_left;
+		rb_link_set(&right->node, child_right);
+		*right_height = height_right;
+		found = node;
+	} else if (res < 0) {
+		found = rb_split_height(child_left, height_left, pivot, cmp,
+					left, left_height, &tmp, &tmp_height);
+		*right_height = rb_join_height(right, rb_link_get(&tmp.node),
+					       tmp_height,
+					       node, child_right,
+					       height_right);
+	} else {
+		found = rb_split_height(child_right, height_right, pivot, cmp,
+					&tmp, &tmp_height, right,
+					right_height);
+		*left_height = rb_join_height(left, child_left, height_left,
+					      node, rb_link_get(&tmp.node),
+					      tmp_height);
+	}
+
+	return found;
+}
+
+/**
+ * rb_split() - Split tree at a pivot node
+ * @root: pointer to rb root of the tree to split, can be @left or @right
+ * @pivot: node to split at, doesn't need to be part of the tree
+ * @cmp: comparison function which returns <0, 0 or >0 when first node is
+ *  smaller, equal or larger than the second node
+ * @left: pointer to rb root for nodes smaller than @pivot
+ * @right: pointer to rb root for nodes larger than @pivot
+ *
+ * The tree is split along the search path of @pivot. The subtrees on the
+ * left and right of the path are joined again to two trees. The runtime is
+ * O(log(n)). @root is empty afterwards (unless used as @left or @right).
+ *
+ * The tree must not contain multiple nodes which are equal to @pivot.
+ *
+ * Return: node equal to @pivot, which is removed from the tree. NULL when no
+ *  such node was found
+ */
+RBTREE_API
+struct rb_node *rb_split(struct rb_root *root, const struct rb_node *pivot,
+			 int (*cmp)(const struct rb_node *node1,
+				    const struct rb_node *node2),
+			 struct rb_root *left, struct rb_root *right)
+{
+	struct rb_node *node = rb_link_get(&root->node);
+	unsigned int left_height;
+	unsigned int right_height;
+	struct rb_node *found;
+
+	rb_link_set(&root->node, NULL);
+
+	found = rb_split_height(node, rb_black_height(node), pivot, cmp, left,
+				&left_height, right, &right_height);
+	if (found) {
+		rb_set_parent_color(found, NULL, RB_BLACK);
+		rb_link_set(&found->left, NULL);
+		rb_link_set(&found->right, NULL);
+	}
+
+	return found;
 }
 
 /**
@@ -256,31 +968,33 @@ static void rb_erase_left_restructure(struct rb_node *parent,
 	struct rb_node *sibling;
 	struct rb_node *tmp;
 
+	rb_stat_inc(erase_left_restructure);
+
 	/* rotate sibling's tree to right
 	 * red becomes right child of new sibling
 	 */
-	sibling = parent->right;
-	tmp = sibling->left;
-	sibling->left = tmp->right;
-	tmp->right = sibling;
+	sibling = rb_right(parent);
+	tmp = rb_left(sibling);
+	rb_link_set(&sibling->left, rb_right(tmp));
+	rb_link_set(&tmp->right, sibling);
 
 	/* fix colors and parent entries for sibling tree
 	 * sibling must become red
 	 */
-	rb_rotate_switch_parents(tmp, sibling, sibling->left, root, RB_RED);
+	rb_rotate_switch_parents(tmp, sibling, rb_left(sibling), root, RB_RED);
 
 	/* rotate parents tree to the left
 	 * parent becomes red and sibling, red can be borrowed
 	 * (changed to black) for double black of node
 	 */
-	tmp = parent->right;
-	parent->right = tmp->left;
-	tmp->left = parent;
+	tmp = rb_right(parent);
+	rb_link_set(&parent->right, rb_left(tmp));
+	rb_link_set(&tmp->left, parent);
 
 	/* fix colors and parent entries for parent tree
 	 * parent must have become black
 	 */
-	rb_rotate_switch_parents(tmp, parent, parent->right, root, RB_BLACK);
+	rb_rotate_switch_parents(tmp, parent, rb_right(parent), root, RB_BLACK);
 
 	/**
 	 * the rotation in the parent tree (both child black)
@@ -291,7 +1005,7 @@ static void rb_erase_left_restructure(struct rb_node *parent,
 	 * has to be changed to have the right tree again at the
 	 * same height
 	 */
-	rb_set_color(tmp->right, RB_BLACK);
+	rb_set_color(rb_right(tmp), RB_BLACK);
 }
 
 /**
@@ -307,21 +1021,23 @@ static void rb_erase_left_recolor_red(struct rb_node *parent,
 {
 	struct rb_node *tmp;
 
+	rb_stat_inc(erase_left_recolor_red);
+
 	/* increase black-height of parent */
 	rb_set_color(parent, RB_BLACK);
 
 	/* decrease black-height of sibling  */
-	rb_set_color(parent->right, RB_RED);
+	rb_set_color(rb_right(parent), RB_RED);
 
 	/* rotate left to make LLRB */
-	tmp = parent->right;
-	parent->right = tmp->left;
-	tmp->left = parent;
+	tmp = rb_right(parent);
+	rb_link_set(&parent->right, rb_left(tmp));
+	rb_link_set(&tmp->left, parent);
 
 	/* fix colors and parent entries
 	 * node must become red during rotate
 	 */
-	rb_rotate_switch_parents(tmp, parent, parent->right, root, RB_RED);
+	rb_rotate_switch_parents(tmp, parent, rb_right(parent), root, RB_RED);
 }
 
 /**
@@ -339,18 +1055,20 @@ static struct rb_node *rb_erase_left_recolor_black(struct rb_node *parent,
 {
 	struct rb_node *tmp;
 
+	rb_stat_inc(erase_left_recolor_black);
+
 	/* decrease black-height of sibling  */
-	rb_set_color(parent->right, RB_RED);
+	rb_set_color(rb_right(parent), RB_RED);
 
 	/* rotate left to make LLRB again */
-	tmp = parent->right;
-	parent->right = tmp->left;
-	tmp->left = parent;
+	tmp = rb_right(parent);
+	rb_link_set(&parent->right, rb_left(tmp));
+	rb_link_set(&tmp->left, parent);
 
 	/* fix colors and parent entries
 	 * node must become red during rotate
 	 */
-	rb_rotate_switch_parents(tmp, parent, parent->right, root, RB_RED);
+	rb_rotate_switch_parents(tmp, parent, rb_right(parent), root, RB_RED);
 
 	/* continue at grand-parent to fix parents
 	 * 'double-black'ness
@@ -371,10 +1089,12 @@ static void rb_erase_right_adjust_black(struct rb_node *parent,
 {
 	struct rb_node *tmp;
 
+	rb_stat_inc(erase_right_adjust_black);
+
 	/* rotate right */
-	tmp = parent->left;
-	parent->left = tmp->right;
-	tmp->right = parent;
+	tmp = rb_left(parent);
+	rb_link_set(&parent->left, rb_right(tmp));
+	rb_link_set(&tmp->right, parent);
 
 	/* fix colors and parent entries
 	 *
@@ -383,7 +1103,7 @@ static void rb_erase_right_adjust_black(struct rb_node *parent,
 	 *
 	 * this caused a right-leaning red node
 	 */
-	rb_rotate_switch_parents(tmp, parent, parent->left, root, RB_RED);
+	rb_rotate_switch_parents(tmp, parent, rb_left(parent), root, RB_RED);
 
 	/* recolor when sibling's children are black
 	 * already known that parent (right leaning is red
@@ -393,7 +1113,7 @@ static void rb_erase_right_adjust_black(struct rb_node *parent,
 	 * height
 	 */
 	rb_set_color(parent, RB_BLACK);
-	rb_set_color(parent->left, RB_RED);
+	rb_set_color(rb_left(parent), RB_RED);
 }
 
 /**
@@ -410,31 +1130,33 @@ static void rb_erase_right_adjust_red(struct rb_node *parent,
 	struct rb_node *sibling;
 	struct rb_node *tmp;
 
+	rb_stat_inc(erase_right_adjust_red);
+
 	/* rotate sibling's tree to left */
-	sibling = parent->left;
-	tmp = sibling->right;
-	sibling->right = tmp->left;
-	tmp->left = sibling;
+	sibling = rb_left(parent);
+	tmp = rb_right(sibling);
+	rb_link_set(&sibling->right, rb_left(tmp));
+	rb_link_set(&tmp->left, sibling);
 
 	/* fix colors and parent entries for sibling tree
 	 * sibling should become black
 	 * but lets do the recolor to red in this step
 	 */
-	rb_rotate_switch_parents(tmp, sibling, sibling->right, root, RB_RED);
+	rb_rotate_switch_parents(tmp, sibling, rb_right(sibling), root, RB_RED);
 
 	/* recolor right child of sibling to black to fix its black height */
-	rb_set_color(sibling->right, RB_BLACK);
+	rb_set_color(rb_right(sibling), RB_BLACK);
 
 	/* rotate parent's tree to right */
-	tmp = parent->left;
-	parent->left = tmp->right;
-	tmp->right = parent;
+	tmp = rb_left(parent);
+	rb_link_set(&parent->left, rb_right(tmp));
+	rb_link_set(&tmp->right, parent);
 
 	/* fix colors and parent entries for parent tree
 	 * parent should become red
 	 * but lets do the recolor to black in this step
 	 */
-	rb_rotate_switch_parents(tmp, parent, parent->left, root, RB_BLACK);
+	rb_rotate_switch_parents(tmp, parent, rb_left(parent), root, RB_BLACK);
 }
 
 /**
@@ -446,7 +1168,7 @@ static void rb_erase_right_adjust_red(struct rb_node *parent,
  */
 static void rb_erase_right_adjust(struct rb_node *parent, struct rb_root *root)
 {
-	if (rb_is_red(parent->left->right->left))
+	if (rb_is_red(rb_left(rb_right(rb_left(parent)))))
 		rb_erase_right_adjust_red(parent, root);
 	else
 		rb_erase_right_adjust_black(parent, root);
@@ -462,6 +1184,8 @@ static void rb_erase_right_restructure(struct rb_node *parent,
 {
 	struct rb_node *tmp;
 
+	rb_stat_inc(erase_right_restructure);
+
 	/* if left child of left sibling is red
 	 * rotate sibling and parent to convert unbalanced
 	 * 1x 2-nodes + 1x 3-node to balanced 2x 2-nodes
@@ -473,14 +1197,14 @@ static void rb_erase_right_restructure(struct rb_node *parent,
 	 */
 
 	/* rotate parents tree to the right */
-	tmp = parent->left;
-	parent->left = tmp->right;
-	tmp->right = parent;
+	tmp = rb_left(parent);
+	rb_link_set(&parent->left, rb_right(tmp));
+	rb_link_set(&tmp->right, parent);
 
 	/* fix colors and parent entries for parent tree
 	 * parent must have become black
 	 */
-	rb_rotate_switch_parents(tmp, parent, parent->left, root, RB_BLACK);
+	rb_rotate_switch_parents(tmp, parent, rb_left(parent), root, RB_BLACK);
 
 	/**
 	 * the rotation increased the black-height of the right
@@ -488,7 +1212,7 @@ static void rb_erase_right_restructure(struct rb_node *parent,
 	 * tree has to compensate by turning the red node to
 	 * black (splitting 3-node into 2x 2-nodes)
 	 */
-	rb_set_color(tmp->left, RB_BLACK);
+	rb_set_color(rb_left(tmp), RB_BLACK);
 }
 
 /**
@@ -501,11 +1225,13 @@ static void rb_erase_right_restructure(struct rb_node *parent,
  */
 static void rb_erase_right_recolor_red(struct rb_node *parent)
 {
+	rb_stat_inc(erase_right_recolor_red);
+
 	/* increase black-height of parent */
 	rb_set_color(parent, RB_BLACK);
 
 	/* decrease black-height of sibling  */
-	rb_set_color(parent->left, RB_RED);
+	rb_set_color(rb_left(parent), RB_RED);
 }
 
 /**
@@ -518,8 +1244,10 @@ static void rb_erase_right_recolor_red(struct rb_node *parent)
  */
 static void rb_erase_right_recolor_black(struct rb_node *parent)
 {
+	rb_stat_inc(erase_right_recolor_black);
+
 	/* decrease black-height of sibling  */
-	rb_set_color(parent->left, RB_RED);
+	rb_set_color(rb_left(parent), RB_RED);
 
 	/* continue at grand-parent to fix parents 'double-black'ness */
 }
@@ -528,6 +1256,8 @@ static void rb_erase_right_recolor_black(struct rb_node *parent)
  * rb_erase_node() - Remove rb node from tree
  * @node: pointer to the node
  * @root: pointer to rb root
+ * @successor: set to the smallest node of the right subtree when it took over
+ *  the position of @node, NULL otherwise
  *
  * The node is only removed from the tree. Neither the memory of the removed
  * node nor the memory of the entry containing the node is free'd. The node
@@ -542,14 +1272,17 @@ static void rb_erase_right_recolor_black(struct rb_node *parent)
  * Return: node which is double black and has to be rebalanced, NULL if no
  *  rebalance is necessary
  */
-static struct rb_node *rb_erase_node(struct rb_node *node, struct rb_root *root)
+static struct rb_node *rb_erase_node(struct rb_node *node, struct rb_root *root,
+				     struct rb_node **successor)
 {
 	struct rb_node *smallest;
 	struct rb_node *smallest_parent;
 	struct rb_node *dblack;
 	enum rb_node_color smallest_color;
 
-	if (!node->left) {
+	*successor = NULL;
+
+	if (!rb_left(node)) {
 		/* no child
 		 * just delete the current child
 		 */
@@ -564,12 +1297,12 @@ static struct rb_node *rb_erase_node(struct rb_node *node, struct rb_root *root)
 			return NULL;
 		else
 			return rb_parent(node);
-	} else if (!node->right) {
+	} else if (!rb_right(node)) {
 		/* one child, left
 		 * use left child as replacement for the deleted node
 		 */
-		rb_set_parent_color(node->left, rb_parent(node), RB_BLACK);
-		rb_change_child(node, node->left, rb_parent(node), root);
+		rb_set_parent_color(rb_left(node), rb_parent(node), RB_BLACK);
+		rb_change_child(node, rb_left(node), rb_parent(node), root);
 
 		/* the left child must be red when there is no right child
 		 * (3-node). Otherwise the subtrees would have different
@@ -580,28 +1313,29 @@ static struct rb_node *rb_erase_node(struct rb_node *node, struct rb_root *root)
 	}
 
 	/* two children, take smallest of right (grand)children */
-	smallest = node->right;
-	while (smallest->left)
-		smallest = smallest->left;
+	smallest = rb_right(node);
+	while (rb_left(smallest))
+		smallest = rb_left(smallest);
 
+	*successor = smallest;
 	smallest_parent = rb_parent(smallest);
 	smallest_color = rb_color(smallest);
-	if (smallest == node->right)
-		dblack = node->right;
+	if (smallest == rb_right(node))
+		dblack = rb_right(node);
 	else
 		dblack = smallest_parent;
 
-	rb_change_child(smallest, smallest->right, smallest_parent, root);
+	rb_change_child(smallest, rb_right(smallest), smallest_parent, root);
 
 	/* exchange node with smallest */
 	rb_set_parent_color(smallest, rb_parent(node), rb_color(node));
 
-	smallest->left = node->left;
-	rb_set_parent(smallest->left, smallest);
+	rb_link_set(&smallest->left, rb_left(node));
+	rb_set_parent(rb_left(smallest), smallest);
 
-	smallest->right = node->right;
-	if (smallest->right)
-		rb_set_parent(smallest->right, smallest);
+	rb_link_set(&smallest->right, rb_right(node));
+	if (rb_right(smallest))
+		rb_set_parent(rb_right(smallest), smallest);
 
 	rb_change_child(node, smallest, rb_parent(node), root);
 
@@ -637,15 +1371,16 @@ static void rb_erase_color(struct rb_node *parent, struct rb_root *root)
 	 * otherwise the left child was the smallest during erase and thus
 	 * it was removed
 	 */
-	if (!parent->right)
+	if (!rb_right(parent))
 		coming_from_right = 1;
 
 	/* go tree upwards and fix the nodes on the way */
 	while (1) {
+		rb_stat_inc(erase_path);
 		gparent = rb_parent(parent);
 
 		if (!coming_from_right) {
-			if (rb_is_red(parent->right->left)) {
+			if (rb_is_red(rb_left(rb_right(parent)))) {
 				rb_erase_left_restructure(parent, root);
 				break;
 			} else if (rb_is_red(parent)) {
@@ -660,10 +1395,10 @@ static void rb_erase_color(struct rb_node *parent, struct rb_root *root)
 				gparent = rb_parent(parent);
 			}
 		} else {
-			if (rb_is_red(parent->left)) {
+			if (rb_is_red(rb_left(parent))) {
 				rb_erase_right_adjust(parent, root);
 				break;
-			} else if (rb_is_red(parent->left->left)) {
+			} else if (rb_is_red(rb_left(rb_left(parent)))) {
 				rb_erase_right_restructure(parent, root);
 				break;
 			} else if (rb_is_red(parent)) {
@@ -685,7 +1420,7 @@ static void rb_erase_color(struct rb_node *parent, struct rb_root *root)
 			break;
 		}
 
-		if (gparent->left == parent)
+		if (rb_left(gparent) == parent)
 			coming_from_right = 0;
 		else
 			coming_from_right = 1;
@@ -699,13 +1434,55 @@ static void rb_erase_color(struct rb_node *parent, struct rb_root *root)
  * @node: pointer to the node
  * @root: pointer to rb root
  */
+RBTREE_API
 void rb_erase(struct rb_node *node, struct rb_root *root)
 {
 	struct rb_node *dblack_node;
+	struct rb_node *successor;
+
+	rb_trace_enter(erase, node);
+	rb_stat_inc(erase);
 
-	dblack_node = rb_erase_node(node, root);
+	dblack_node = rb_erase_node(node, root, &successor);
 	if (dblack_node)
 		rb_erase_color(dblack_node, root);
+
+	rb_trace_exit(erase, RB_TRACE_ERASE, node);
+}
+
+/**
+ * rb_erase_first() - Remove leftmost rb node from tree and rebalance tree
+ * @node: pointer to the leftmost node of the tree (rb_first)
+ * @root: pointer to rb root
+ *
+ * The leftmost node of a LLRB tree has no left child. It also cannot have a
+ * right child because the black heights of both subtrees would differ
+ * otherwise. It is therefore always removed like a leaf and its parent
+ * becomes the new leftmost node.
+ *
+ * Return: pointer to the new leftmost node. NULL when @root is empty now.
+ */
+RBTREE_API
+struct rb_node *rb_erase_first(struct rb_node *node, struct rb_root *root)
+{
+	struct rb_node *parent = rb_parent(node);
+
+	rb_trace_enter(erase, node);
+	rb_stat_inc(erase);
+
+	if (!parent) {
+		rb_link_set(&root->node, NULL);
+	} else {
+		rb_link_set(&parent->left, NULL);
+
+		/* removing a black leaf makes its parent double black */
+		if (!rb_is_red(node))
+			rb_erase_color(parent, root);
+	}
+
+	rb_trace_exit(erase, RB_TRACE_ERASE, node);
+
+	return parent;
 }
 
 /**
@@ -714,16 +1491,17 @@ void rb_erase(struct rb_node *node, struct rb_root *root)
  *
  * Return: pointer to leftmost node. NULL when @root is empty.
  */
+RBTREE_API
 struct rb_node *rb_first(const struct rb_root *root)
 {
-	struct rb_node *node = root->node;
+	struct rb_node *node = rb_link_get(&root->node);
 
 	if (!node)
 		return node;
 
 	/* descend down via smaller/preceding child */
-	while (node->left)
-		node = node->left;
+	while (rb_left(node))
+		node = rb_left(node);
 
 	return node;
 }
@@ -734,35 +1512,36 @@ struct rb_node *rb_first(const struct rb_root *root)
  *
  * Return: pointer to rightmost node. NULL when @root is empty.
  */
+RBTREE_API
 struct rb_node *rb_last(const struct rb_root *root)
 {
-	struct rb_node *node = root->node;
+	struct rb_node *node = rb_link_get(&root->node);
 
 	if (!node)
 		return node;
 
 	/* descend down via larger/succeeding child */
-	while (node->right)
-		node = node->right;
+	while (rb_right(node))
+		node = rb_right(node);
 
 	return node;
 }
 
 /**
- * rb_next() - Find successor node in tree
+ * rb_next_node() - Find successor node in tree
  * @node: starting rb node for search
  *
  * Return: pointer to successor node. NULL when no successor of @node exist.
  */
-struct rb_node *rb_next(struct rb_node *node)
+static struct rb_node *rb_next_node(struct rb_node *node)
 {
 	struct rb_node *parent;
 
 	/* there is a right child - next node must be the leftmost under it */
-	if (node->right) {
-		node = node->right;
-		while (node->left)
-			node = node->left;
+	if (rb_right(node)) {
+		node = rb_right(node);
+		while (rb_left(node))
+			node = rb_left(node);
 
 		return node;
 	}
@@ -775,7 +1554,7 @@ struct rb_node *rb_next(struct rb_node *node)
 	/* go up the tree until the path connecting both is the left child
 	 * pointer and therefore the parent is the next node
 	 */
-	while (parent && parent->right == node) {
+	while (parent && rb_right(parent) == node) {
 		node = parent;
 		parent = rb_parent(node);
 	}
@@ -783,21 +1562,40 @@ struct rb_node *rb_next(struct rb_node *node)
 	return parent;
 }
 
+/**
+ * rb_next() - Find successor node in tree
+ * @node: starting rb node for search
+ *
+ * Return: pointer to successor node. NULL when no successor of @node exist.
+ */
+RBTREE_API
+struct rb_node *rb_next(struct rb_node *node)
+{
+	struct rb_node *next;
+
+	rb_trace_enter(next, node);
+	next = rb_next_node(node);
+	rb_trace_exit(next, RB_TRACE_NEXT, next);
+
+	return next;
+}
+
 /**
  * rb_prev() - Find predecessor node in tree
  * @node: starting rb node for search
  *
  * Return: pointer to predecessor node. NULL when no predecessor of @node exist.
  */
+RBTREE_API
 struct rb_node *rb_prev(struct rb_node *node)
 {
 	struct rb_node *parent;
 
 	/* there is a left child - prev node must be the rightmost under it */
-	if (node->left) {
-		node = node->left;
-		while (node->right)
-			node = node->right;
+	if (rb_left(node)) {
+		node = rb_left(node);
+		while (rb_right(node))
+			node = rb_right(node);
 
 		return node;
 	}
@@ -810,10 +1608,893 @@ struct rb_node *rb_prev(struct rb_node *node)
 	/* go up the tree until the path connecting both is the right child
 	 * pointer and therefore the parent is the prev node
 	 */
-	while (parent && parent->left == node) {
+	while (parent && rb_left(parent) == node) {
 		node = parent;
 		parent = rb_parent(node);
 	}
 
 	return parent;
 }
+
+/**
+ * rb_erase_next() - Remove rb node from tree and return its successor
+ * @node: pointer to the node
+ * @root: pointer to rb root
+ *
+ * A node with a right child is replaced by the smallest node of its right
+ * subtree during the erase. This node is its successor and is returned
+ * without an additional search. Otherwise, the successor is an ancestor of
+ * @node and stays the successor after the erase.
+ *
+ * Return: pointer to successor node. NULL when no successor of @node existed.
+ */
+RBTREE_API
+struct rb_node *rb_erase_next(struct rb_node *node, struct rb_root *root)
+{
+	struct rb_node *dblack_node;
+	struct rb_node *successor;
+	struct rb_node *next = NULL;
+
+	rb_trace_enter(erase, node);
+	rb_stat_inc(erase);
+
+	if (!rb_right(node))
+		next = rb_next_node(node);
+
+	dblack_node = rb_erase_node(node, root, &successor);
+	if (dblack_node)
+		rb_erase_color(dblack_node, root);
+
+	rb_trace_exit(erase, RB_TRACE_ERASE, node);
+
+	if (successor)
+		next = successor;
+
+	return next;
+}
+
+/**
+ * rb_erase_prev() - Remove rb node from tree and return its predecessor
+ * @node: pointer to the node
+ * @root: pointer to rb root
+ *
+ * The predecessor is searched before the erase. It is not moved by the erase
+ * and therefore stays the predecessor.
+ *
+ * Return: pointer to predecessor node. NULL when no predecessor of @node
+ *  existed.
+ */
+RBTREE_API
+struct rb_node *rb_erase_prev(struct rb_node *node, struct rb_root *root)
+{
+	struct rb_node *prev = rb_prev(node);
+
+	rb_erase(node, root);
+
+	return prev;
+}
+
+/**
+ * rb_mnode_link_get() - Get entry of a duplicate chain link
+ * @link: pointer to the next or prev link of an entry
+ *
+ * Return: entry referenced by @link
+ */
+static struct rb_mnode *rb_mnode_link_get(RB_LINK const *link)
+{
+	return rb_entry(rb_link_get(link), struct rb_mnode, rb);
+}
+
+/**
+ * rb_mnode_is_head() - Check if entry is first entry of its key
+ * @mnode: pointer to the entry
+ *
+ * Only the first entry of a key is part of the tree. The other entries are
+ * marked as red nodes without parent. Such a node cannot exist in the tree
+ * because the root node is always black.
+ *
+ * Return: 1 when @mnode is part of the tree, 0 otherwise
+ */
+static int rb_mnode_is_head(struct rb_mnode *mnode)
+{
+	if (rb_parent(&mnode->rb))
+		return 1;
+
+	return !rb_is_red(&mnode->rb);
+}
+
+/**
+ * rb_minsert() - Add entry to multimap tree
+ * @mnode: pointer to the new entry
+ * @root: pointer to rb root
+ * @cmp: comparison function which returns <0, 0 or >0 when first node is
+ *  smaller, equal or larger than the second node
+ *
+ * The entry is appended to the chain of an already existing entry with the
+ * same key. The tree is not modified in this case. Otherwise it is inserted
+ * as new node. The height of the tree therefore only depends on the number
+ * of distinct keys.
+ */
+RBTREE_API
+void rb_minsert(struct rb_mnode *mnode, struct rb_root *root,
+		int (*cmp)(const struct rb_node *node1,
+			   const struct rb_node *node2))
+{
+	RB_LINK *rb_link = &root->node;
+	struct rb_node *parent = NULL;
+	struct rb_mnode *head;
+	struct rb_mnode *tail;
+	struct rb_node *node;
+	int res;
+
+	while ((node = rb_link_get(rb_link))) {
+		parent = node;
+
+		res = cmp(&mnode->rb, node);
+		if (res == 0) {
+			head = rb_entry(node, struct rb_mnode, rb);
+			tail = rb_mnode_link_get(&head->prev);
+
+			rb_set_parent_color(&mnode->rb, NULL, RB_RED);
+			rb_link_set(&mnode->rb.left, NULL);
+			rb_link_set(&mnode->rb.right, NULL);
+
+			rb_link_set(&mnode->next, &head->rb);
+			rb_link_set(&mnode->prev, &tail->rb);
+			rb_link_set(&tail->next, &mnode->rb);
+			rb_link_set(&head->prev, &mnode->rb);
+			return;
+		}
+
+		if (res < 0)
+			rb_link = &node->left;
+		else
+			rb_link = &node->right;
+	}
+
+	rb_link_set(&mnode->next, &mnode->rb);
+	rb_link_set(&mnode->prev, &mnode->rb);
+	rb_insert(&mnode->rb, parent, rb_link, root);
+}
+
+/**
+ * rb_merase() - Remove entry from multimap tree
+ * @mnode: pointer to the entry
+ * @root: pointer to rb root
+ *
+ * Entries which are not the first of their key are only unlinked from the
+ * chain. The first entry is replaced in the tree by the second entry of the
+ * chain without any rebalancing. Only the last entry of a key is removed via
+ * rb_erase.
+ */
+RBTREE_API
+void rb_merase(struct rb_mnode *mnode, struct rb_root *root)
+{
+	struct rb_mnode *next = rb_mnode_link_get(&mnode->next);
+	struct rb_mnode *prev = rb_mnode_link_get(&mnode->prev);
+
+	if (next == mnode) {
+		rb_erase(&mnode->rb, root);
+		return;
+	}
+
+	rb_link_set(&prev->next, &next->rb);
+	rb_link_set(&next->prev, &prev->rb);
+
+	if (rb_mnode_is_head(mnode))
+		rb_replace_node(&mnode->rb, &next->rb, root);
+}
+
+/**
+ * rb_mfirst() - Find first entry in multimap tree
+ * @root: pointer to rb root
+ *
+ * Return: pointer to first entry of the smallest key. NULL when @root is
+ *  empty.
+ */
+RBTREE_API
+struct rb_mnode *rb_mfirst(const struct rb_root *root)
+{
+	struct rb_node *node = rb_first(root);
+
+	if (!node)
+		return NULL;
+
+	return rb_entry(node, struct rb_mnode, rb);
+}
+
+/**
+ * rb_mlast() - Find last entry in multimap tree
+ * @root: pointer to rb root
+ *
+ * Return: pointer to last entry of the largest key. NULL when @root is
+ *  empty.
+ */
+RBTREE_API
+struct rb_mnode *rb_mlast(const struct rb_root *root)
+{
+	struct rb_node *node = rb_last(root);
+
+	if (!node)
+		return NULL;
+
+	return rb_mnode_link_get(&rb_entry(node, struct rb_mnode, rb)->prev);
+}
+
+/**
+ * rb_mnext() - Find successor entry in multimap tree
+ * @mnode: starting entry for search
+ *
+ * Entries with the same key are returned in insertion order.
+ *
+ * Return: pointer to successor entry. NULL when no successor of @mnode exist.
+ */
+RBTREE_API
+struct rb_mnode *rb_mnext(struct rb_mnode *mnode)
+{
+	struct rb_mnode *next = rb_mnode_link_get(&mnode->next);
+	struct rb_node *node;
+
+	if (!rb_mnode_is_head(next))
+		return next;
+
+	/* wrapped around to the first entry of the key */
+	node = rb_next(&next->rb);
+	if (!node)
+		return NULL;
+
+	return rb_entry(node, struct rb_mnode, rb);
+}
+
+/**
+ * rb_mprev() - Find predecessor entry in multimap tree
+ * @mnode: starting entry for search
+ *
+ * Return: pointer to predecessor entry. NULL when no predecessor of @mnode
+ *  exist.
+ */
+RBTREE_API
+struct rb_mnode *rb_mprev(struct rb_mnode *mnode)
+{
+	struct rb_node *node;
+
+	if (!rb_mnode_is_head(mnode))
+		return rb_mnode_link_get(&mnode->prev);
+
+	node = rb_prev(&mnode->rb);
+	if (!node)
+		return NULL;
+
+	/* last entry of the previous key */
+	return rb_mnode_link_get(&rb_entry(node, struct rb_mnode, rb)->prev);
+}
+
+/**
+ * rb_lower_bound_from() - Find first node not smaller than key near finger
+ * @node: finger rb node in the tree where the search starts
+ * @key: pointer to the key to search for
+ * @cmp: comparison function which returns <0, 0 or >0 when @key is smaller,
+ *  equal or larger than the node
+ *
+ * The tree is only climbed upwards from @node until the ancestor's subtree
+ * must contain the searched node. The search then descends again from this
+ * ancestor. The cost is therefore bound by the distance between @node and the
+ * searched node instead of the size of the tree. This allows to move cursors
+ * (like the ones used with rb_next/rb_prev) forward and backward to a key.
+ *
+ * Return: pointer to first node which is not smaller than @key. NULL when all
+ *  nodes are smaller than @key
+ */
+RBTREE_API
+struct rb_node *rb_lower_bound_from(struct rb_node *node, const void *key,
+				    int (*cmp)(const void *key,
+					       const struct rb_node *node))
+{
+	struct rb_node *parent;
+	struct rb_node *result;
+
+	if (cmp(key, node) > 0) {
+		/* searched node is after finger. go up until a larger
+		 * ancestor is found which is not smaller than key. Ancestors
+		 * reached via right child pointer are smaller than finger
+		 */
+		result = NULL;
+		while ((parent = rb_parent(node))) {
+			if (rb_left(parent) == node && cmp(key, parent) <= 0) {
+				result = parent;
+				break;
+			}
+
+			node = parent;
+		}
+
+		/* node is smaller than key - only right subtree has to be
+		 * searched
+		 */
+		node = rb_right(node);
+	} else {
+		/* searched node is finger or before it. go up until a smaller
+		 * ancestor is found which is smaller than key. Ancestors
+		 * reached via left child pointer are larger than finger
+		 */
+		while ((parent = rb_parent(node))) {
+			if (rb_right(parent) == node && cmp(key, parent) > 0)
+				break;
+
+			node = parent;
+		}
+
+		/* node is not smaller than key - only left subtree has to be
+		 * searched for better candidates
+		 */
+		result = node;
+		node = rb_left(node);
+	}
+
+	/* descend down to the first node not smaller than key */
+	while (node) {
+		if (cmp(key, node) <= 0) {
+			result = node;
+			node = rb_left(node);
+		} else {
+			node = rb_right(node);
+		}
+	}
+
+	return result;
+}
+
+/**
+ * rb_search_batch() - Descend to multiple keys in lock-step
+ * @root: pointer to rb root
+ * @keys: array of pointers to the keys to search for
+ * @results: array for the found nodes (same size as @keys)
+ * @count: number of entries in @keys
+ * @cmp: comparison function which returns <0, 0 or >0 when key is smaller,
+ *  equal or larger than the node
+ * @exact: 1 when only equal nodes should be returned, 0 to return the first
+ *  node which is not smaller than the key
+ *
+ * The keys are processed in groups of RB_BATCH_GROUP lookups. Each lookup of a
+ * group is moved one level down before the next level of any other lookup is
+ * accessed. The nodes for the next level are prefetched. The memory accesses
+ * of the independent lookups can therefore overlap instead of waiting for each
+ * cache miss one after another.
+ */
+static void rb_search_batch(const struct rb_root *root,
+			    const void * const *keys, struct rb_node **results,
+			    size_t count,
+			    int (*cmp)(const void *key,
+				       const struct rb_node *node),
+			    int exact)
+{
+	struct rb_node *cur[RB_BATCH_GROUP];
+	size_t active;
+	size_t i, j;
+	size_t n;
+	int res;
+
+	for (i = 0; i < count; i += n) {
+		n = count - i;
+		if (n > RB_BATCH_GROUP)
+			n = RB_BATCH_GROUP;
+
+		/* start all lookups of the group at the root */
+		for (j = 0; j < n; j++) {
+			cur[j] = rb_link_get(&root->node);
+			results[i + j] = NULL;
+		}
+
+		if (rb_link_get(&root->node))
+			active = n;
+		else
+			active = 0;
+
+		/* move each unfinished lookup one level down per round */
+		while (active) {
+			for (j = 0; j < n; j++) {
+				if (!cur[j])
+					continue;
+
+				res = cmp(keys[i + j], cur[j]);
+				if (res == 0 && exact) {
+					results[i + j] = cur[j];
+					cur[j] = NULL;
+				} else if (res <= 0) {
+					if (!exact)
+						results[i + j] = cur[j];
+
+					cur[j] = rb_left(cur[j]);
+				} else {
+					cur[j] = rb_right(cur[j]);
+				}
+
+				if (cur[j])
+					rb_prefetch(cur[j]);
+				else
+					active--;
+			}
+		}
+	}
+}
+
+/**
+ * rb_find_batch() - Find nodes equal to multiple keys
+ * @root: pointer to rb root
+ * @keys: array of pointers to the keys to search for
+ * @results: array for the found nodes (same size as @keys)
+ * @count: number of entries in @keys
+ * @cmp: comparison function which returns <0, 0 or >0 when key is smaller,
+ *  equal or larger than the node
+ *
+ * The descents for the keys are interleaved to keep multiple memory accesses
+ * in flight. @results[i] is set to a node equal to @keys[i] or to NULL when no
+ * such node exists.
+ */
+RBTREE_API
+void rb_find_batch(const struct rb_root *root, const void * const *keys,
+		   struct rb_node **results, size_t count,
+		   int (*cmp)(const void *key, const struct rb_node *node))
+{
+	rb_search_batch(root, keys, results, count, cmp, 1);
+}
+
+/**
+ * rb_lower_bound_batch() - Find first nodes not smaller than multiple keys
+ * @root: pointer to rb root
+ * @keys: array of pointers to the keys to search for
+ * @results: array for the found nodes (same size as @keys)
+ * @count: number of entries in @keys
+ * @cmp: comparison function which returns <0, 0 or >0 when key is smaller,
+ *  equal or larger than the node
+ *
+ * The descents for the keys are interleaved to keep multiple memory accesses
+ * in flight. @results[i] is set to the first node which is not smaller than
+ * @keys[i] or to NULL when all nodes are smaller.
+ */
+RBTREE_API
+void rb_lower_bound_batch(const struct rb_root *root, const void * const *keys,
+			  struct rb_node **results, size_t count,
+			  int (*cmp)(const void *key,
+				     const struct rb_node *node))
+{
+	rb_search_batch(root, keys, results, count, cmp, 0);
+}
+
+/**
+ * rb_get_shape() - Calculate size and heights of tree
+ * @root: pointer to rb root
+ * @shape: pointer to the result
+ *
+ * All nodes are visited without recursion by following the child and parent
+ * pointers. The runtime is O(n).
+ */
+RBTREE_API
+void rb_get_shape(const struct rb_root *root, struct rb_shape *shape)
+{
+	struct rb_node *node = rb_link_get(&root->node);
+	struct rb_node *prev = NULL;
+	struct rb_node *next;
+	size_t depth = 1;
+
+	shape->size = 0;
+	shape->height = 0;
+	shape->black_height = 0;
+
+	/* every path has the same number of black nodes */
+	for (next = node; next; next = rb_left(next)) {
+		if (rb_color(next) == RB_BLACK)
+			shape->black_height++;
+	}
+
+	while (node) {
+		if (prev == rb_parent(node)) {
+			/* first visit of node coming from parent */
+			shape->size++;
+			if (depth > shape->height)
+				shape->height = depth;
+
+			if (rb_left(node))
+				next = rb_left(node);
+			else if (rb_right(node))
+				next = rb_right(node);
+			else
+				next = rb_parent(node);
+		} else if (prev == rb_left(node) && rb_right(node)) {
+			/* left subtree done, continue with right subtree */
+			next = rb_right(node);
+		} else {
+			/* both subtrees done */
+			next = rb_parent(node);
+		}
+
+		if (next == rb_parent(node))
+			depth--;
+		else
+			depth++;
+
+		prev = node;
+		node = next;
+	}
+}
+
+/**
+ * rb_level_walk() - Find next node in pre-order with limited depth
+ * @top: root of the walked subtree
+ * @node: current node below @top
+ * @depth: depth of @node below @top, updated to the depth of the result
+ * @level: maximum depth below @top
+ *
+ * Return: next node in pre-order which is not deeper than @level below @top,
+ *  NULL when the walk is finished
+ */
+static struct rb_node *rb_level_walk(struct rb_node *top, struct rb_node *node,
+				     unsigned int *depth, unsigned int level)
+{
+	struct rb_node *parent;
+
+	if (*depth < level) {
+		if (rb_left(node)) {
+			(*depth)++;
+			return rb_left(node);
+		}
+
+		if (rb_right(node)) {
+			(*depth)++;
+			return rb_right(node);
+		}
+	}
+
+	/* go up until a right sibling of the path is found */
+	while (node != top) {
+		parent = rb_parent(node);
+
+		if (rb_left(parent) == node && rb_right(parent))
+			return rb_right(parent);
+
+		node = parent;
+		(*depth)--;
+	}
+
+	return NULL;
+}
+
+/**
+ * rb_level_next() - Find next node on the same level
+ * @top: root of the walked subtree
+ * @node: current node, NULL to start with the first node of the level
+ * @depth: depth of @node below @top, updated to the depth of the result
+ * @level: depth of the searched nodes below @top
+ *
+ * Only the nodes above @level are visited. A level can therefore be iterated
+ * in O(size of the tree above @level) without any additional memory.
+ *
+ * Return: next node which is @level below @top, NULL when no such node exists
+ */
+static struct rb_node *rb_level_next(struct rb_node *top, struct rb_node *node,
+				     unsigned int *depth, unsigned int level)
+{
+	if (!node) {
+		*depth = 0;
+		if (level == 0)
+			return top;
+
+		node = top;
+	}
+
+	do {
+		node = rb_level_walk(top, node, depth, level);
+	} while (node && *depth != level);
+
+	return node;
+}
+
+/**
+ * rb_relayout_push() - Add subtree to the van Emde Boas stack
+ * @relayout: pointer to the relayout state
+ * @top: root of the subtree
+ * @height: height of the subtree
+ */
+static void rb_relayout_push(struct rb_relayout *relayout,
+			     struct rb_node *top, unsigned int height)
+{
+	struct rb_relayout_frame *frame = &relayout->frame[relayout->frames];
+
+	frame->top = top;
+	frame->cursor = NULL;
+	frame->height = height;
+	frame->depth = 0;
+	frame->state = 0;
+	relayout->frames++;
+}
+
+/**
+ * rb_relayout_next_veb() - Select next node in van Emde Boas order
+ * @relayout: pointer to the relayout state
+ *
+ * A subtree is split in a top subtree with half of the height and the bottom
+ * subtrees below it. The top subtree is handled first and then the bottom
+ * subtrees from left to right. The nodes of each subtree are therefore moved
+ * next to each other. The bottom subtrees are found via rb_level_next.
+ *
+ * Return: node to move next, NULL when all nodes were selected
+ */
+static struct rb_node *rb_relayout_next_veb(struct rb_relayout *relayout)
+{
+	struct rb_relayout_frame *frame;
+	struct rb_node *node;
+	unsigned int top_height;
+
+	if (!relayout->started) {
+		relayout->started = 1;
+
+		/* the height of a LLRB is at most twice the black height */
+		node = rb_link_get(&relayout->root->node);
+		if (node)
+			rb_relayout_push(relayout, node,
+					 2 * rb_black_height(node));
+	}
+
+	while (relayout->frames) {
+		frame = &relayout->frame[relayout->frames - 1];
+
+		if (frame->height <= 1) {
+			relayout->frames--;
+			return frame->top;
+		}
+
+		top_height = frame->height / 2;
+		if (frame->state == 0) {
+			frame->state = 1;
+			rb_relayout_push(relayout, frame->top, top_height);
+			continue;
+		}
+
+		frame->state = 2;
+		frame->cursor = rb_level_next(frame->top, frame->cursor,
+					      &frame->depth, top_height);
+		if (!frame->cursor) {
+			relayout->frames--;
+			continue;
+		}
+
+		rb_relayout_push(relayout, frame->cursor,
+				 frame->height - top_height);
+	}
+
+	return NULL;
+}
+
+/**
+ * rb_relayout_next() - Select next node to move
+ * @relayout: pointer to the relayout state
+ *
+ * Return: node to move next, NULL when all nodes were selected
+ */
+static struct rb_node *rb_relayout_next(struct rb_relayout *relayout)
+{
+	struct rb_node *top = rb_link_get(&relayout->root->node);
+
+	if (relayout->order == RB_RELAYOUT_VEB)
+		return rb_relayout_next_veb(relayout);
+
+	if (!relayout->started) {
+		relayout->started = 1;
+
+		if (relayout->order == RB_RELAYOUT_INORDER)
+			relayout->cursor = rb_first(relayout->root);
+		else
+			relayout->cursor = top;
+
+		return relayout->cursor;
+	}
+
+	if (relayout->order == RB_RELAYOUT_INORDER) {
+		relayout->cursor = rb_next(relayout->cursor);
+		return relayout->cursor;
+	}
+
+	/* RB_RELAYOUT_BFS */
+	relayout->cursor = rb_level_next(top, relayout->cursor,
+					 &relayout->depth, relayout->level);
+	if (!relayout->cursor) {
+		relayout->level++;
+		relayout->cursor = rb_level_next(top, NULL, &relayout->depth,
+						 relayout->level);
+	}
+
+	return relayout->cursor;
+}
+
+/**
+ * rb_relayout_move() - Move node and fix links to it
+ * @relayout: pointer to the relayout state
+ * @node: node to move
+ */
+static void rb_relayout_move(struct rb_relayout *relayout,
+			     struct rb_node *node)
+{
+	struct rb_node *parent = rb_parent(node);
+	enum rb_node_color color = rb_color(node);
+	struct rb_node *left = rb_left(node);
+	struct rb_node *right = rb_right(node);
+	struct rb_node *new_node;
+	size_t i;
+
+	new_node = relayout->move(node, relayout->arg);
+	rb_relink_node(node, new_node, parent, color, left, right,
+		       relayout->root);
+
+	/* references in the state must point to the new location */
+	if (relayout->cursor == node)
+		relayout->cursor = new_node;
+
+	for (i = 0; i < relayout->frames; i++) {
+		if (relayout->frame[i].top == node)
+			relayout->frame[i].top = new_node;
+		if (relayout->frame[i].cursor == node)
+			relayout->frame[i].cursor = new_node;
+	}
+}
+
+/**
+ * rb_relayout_init() - Prepare incremental relayout of tree
+ * @relayout: pointer to the relayout state
+ * @root: pointer to rb root
+ * @order: order in which the nodes are moved
+ * @move: function which moves the entry of a node to its new location
+ * @arg: second argument for @move
+ *
+ * @move has to copy the entry which contains the node to its new location
+ * and return the node of the copy. It is called for the nodes in @order. An
+ * arena which is filled sequentially by @move will therefore contain the
+ * entries in @order. The links of the copied node and of its neighbours are
+ * fixed by the relayout afterwards. The old node is not accessed anymore
+ * after @move returned and can be free'd by it.
+ */
+RBTREE_API
+void rb_relayout_init(struct rb_relayout *relayout, struct rb_root *root,
+		      enum rb_relayout_order order,
+		      struct rb_node *(*move)(struct rb_node *node, void *arg),
+		      void *arg)
+{
+	relayout->root = root;
+	relayout->order = order;
+	relayout->move = move;
+	relayout->arg = arg;
+	relayout->cursor = NULL;
+	relayout->depth = 0;
+	relayout->level = 0;
+	relayout->started = 0;
+	relayout->done = 0;
+	relayout->frames = 0;
+}
+
+/**
+ * rb_relayout_step() - Move the next chunk of nodes
+ * @relayout: pointer to the relayout state
+ * @budget: maximum number of nodes to move
+ *
+ * The tree is valid between two steps and can be used for lookups and
+ * iterations. It must not be modified until the relayout is finished. The
+ * state only references moved nodes and needs no memory besides @relayout.
+ * Each moved node costs O(1) amortized for RB_RELAYOUT_INORDER and at most
+ * O(log(n)) amortized for the other orders.
+ *
+ * Return: 1 when more nodes have to be moved, 0 when relayout is finished
+ */
+RBTREE_API
+int rb_relayout_step(struct rb_relayout *relayout, size_t budget)
+{
+	struct rb_node *node;
+
+	for (; budget > 0 && !relayout->done; budget--) {
+		node = rb_relayout_next(relayout);
+		if (!node) {
+			relayout->done = 1;
+			break;
+		}
+
+		rb_relayout_move(relayout, node);
+	}
+
+	return !relayout->done;
+}
+
+/**
+ * rb_relayout() - Move all nodes of a tree in the given order
+ * @root: pointer to rb root
+ * @order: order in which the nodes are moved
+ * @move: function which moves the entry of a node to its new location
+ * @arg: second argument for @move
+ *
+ * See rb_relayout_init for the requirements of @move.
+ */
+RBTREE_API
+void rb_relayout(struct rb_root *root, enum rb_relayout_order order,
+		 struct rb_node *(*move)(struct rb_node *node, void *arg),
+		 void *arg)
+{
+	struct rb_relayout relayout;
+
+	rb_relayout_init(&relayout, root, order, move, arg);
+	while (rb_relayout_step(&relayout, (size_t)-1))
+		;
+}
+
+#ifdef RB_STATS
+/**
+ * rb_stats_get() - Get operation counters of the current thread
+ * @stats: pointer to the result
+ */
+RBTREE_API
+void rb_stats_get(struct rb_stats *stats)
+{
+	*stats = rb_stats_local;
+}
+
+/**
+ * rb_stats_reset() - Reset operation counters of the current thread
+ */
+RBTREE_API
+void rb_stats_reset(void)
+{
+	memset(&rb_stats_local, 0, sizeof(rb_stats_local));
+}
+#endif
+
+#ifdef RB_TRACE
+/**
+ * rb_trace_set_sample_rate() - Set latency sampling rate for all threads
+ * @rate: only every @rate-th operation of a thread is sampled. 0 and 1 sample
+ *  every operation
+ *
+ * The rate should be set before any thread starts to use the tree functions.
+ */
+RBTREE_API
+void rb_trace_set_sample_rate(unsigned int rate)
+{
+	rb_trace_sample_rate = rate;
+}
+
+/**
+ * rb_latency_get() - Get latency histogram of the current thread
+ * @op: type of the operation
+ * @hist: pointer to the result
+ */
+RBTREE_API
+void rb_latency_get(enum rb_trace_op op, struct rb_latency_hist *hist)
+{
+	*hist = rb_trace_local.hist[op];
+}
+
+/**
+ * rb_latency_reset() - Reset latency histograms of the current thread
+ */
+RBTREE_API
+void rb_latency_reset(void)
+{
+	memset(rb_trace_local.hist, 0, sizeof(rb_trace_local.hist));
+}
+
+/**
+ * rb_latency_bucket_value() - Get smallest latency of histogram bucket
+ * @bucket: index of the bucket in struct rb_latency_hist
+ *
+ * Return: smallest latency in nanoseconds which is counted in @bucket
+ */
+RBTREE_API
+unsigned long rb_latency_bucket_value(size_t bucket)
+{
+	size_t shift;
+	unsigned long sub;
+
+	if (bucket < 2 * RB_LATENCY_SUB_BUCKETS)
+		return bucket;
+
+	shift = bucket / RB_LATENCY_SUB_BUCKETS - 1;
+	sub = bucket % RB_LATENCY_SUB_BUCKETS;
+
+	return (RB_LATENCY_SUB_BUCKETS + sub) << shift;
+}
+#endif
@@ -26,6 +26,29 @@ extern "C" {
 #define RB_NODE_ALIGNED __declspec(align(sizeof(unsigned long)))
 #endif
 
+/* RB_RELATIVE_POINTERS stores parent and child links as self-relative offsets
+ * instead of pointers. A tree in a shared memory segment or a mmap'ed file
+ * can then be used at any mapping address. The root has to be stored in the
+ * same mapping. The links must be accessed via rb_link_get, rb_left and
+ * rb_right in this mode. A root also cannot be copied by value, its node has
+ * to be transferred with rb_link_set and rb_link_get.
+ */
+#ifdef RB_RELATIVE_POINTERS
+#define RB_LINK ptrdiff_t
+#else
+#define RB_LINK struct rb_node *
+#endif
+
+/* RBTREE_INLINE includes the implementation as static inline functions. The
+ * RB_STATS/RB_TRACE state is then private to each translation unit. RB_TRACE
+ * additionally requires _POSIX_C_SOURCE >= 199309L before any system header.
+ */
+#ifdef RBTREE_INLINE
+#define RBTREE_API static __inline__
+#else
+#define RBTREE_API
+#endif
+
 /**
  * container_of() - Calculate address of object that contains address ptr
  * @ptr: pointer to member variable
@@ -59,9 +82,10 @@ enum rb_node_color {
  * struct rb_node - node of a red-black tree
  * @parent: pointer to the parent node in the tree
  * @color: color of the node
- * @parent_color: combination of @parent and @color (lowest bit)
- * @left: pointer to the left child in the tree
- * @right: pointer to the right child in the tree
+ * @parent_color: combination of @parent and @color (lowest bit). Offset from
+ *  the node to the parent with RB_RELATIVE_POINTERS
+ * @left: link to the left child in the tree
+ * @right: link to the right child in the tree
  *
  * The red-black tree consists of a root and nodes attached to this root. The
  * rb_* functions and macros can be used to access and modify this data
@@ -76,32 +100,243 @@ enum rb_node_color {
  * can be used to calculate the object address from the address of the node.
  */
 struct rb_node {
-#ifndef RB_PARENT_COLOR_COMBINATION
+#if defined(RB_RELATIVE_POINTERS)
+	ptrdiff_t parent_color;
+#elif !defined(RB_PARENT_COLOR_COMBINATION)
 	struct rb_node *parent;
 	enum rb_node_color color;
 #else
 	unsigned long parent_color;
 #endif
-	struct rb_node *left;
-	struct rb_node *right;
+	RB_LINK left;
+	RB_LINK right;
 } RB_NODE_ALIGNED;
 
 /**
  * struct rb_root - root of a red-black-tree
- * @node: pointer to the root node in the tree
+ * @node: link to the root node in the tree
  *
  * For an empty tree, node points to NULL.
  */
 struct rb_root {
-	struct rb_node *node;
+	RB_LINK node;
 };
 
+/**
+ * struct rb_mnode - entry of a red-black tree with chained duplicate keys
+ * @rb: node in the tree. Only used by the first entry of a key
+ * @next: link to the next entry with the same key. The last entry links to
+ *  the first entry
+ * @prev: link to the previous entry with the same key. The first entry links
+ *  to the last entry
+ *
+ * The rb_m* functions store all entries with the same key in a circular list
+ * which hangs off the first entry. Only this first entry is a node of the
+ * tree. The tree functions for lookups (rb_first, rb_next, ...) therefore
+ * only return the first entry of each key. The complete multimap can be
+ * iterated with rb_mfirst, rb_mnext, rb_mlast and rb_mprev.
+ */
+struct rb_mnode {
+	struct rb_node rb;
+	RB_LINK next;
+	RB_LINK prev;
+};
+
+/**
+ * struct rb_shape - size and heights of a red-black-tree
+ * @size: number of nodes in the tree
+ * @height: number of nodes on the longest path from the root to a leaf
+ * @black_height: number of black nodes on each path from the root to a leaf
+ */
+struct rb_shape {
+	size_t size;
+	size_t height;
+	size_t black_height;
+};
+
+/**
+ * enum rb_relayout_order - order of the moved nodes during rb_relayout
+ * @RB_RELAYOUT_INORDER: sorted like rb_first/rb_next
+ * @RB_RELAYOUT_BFS: level by level starting at the root
+ * @RB_RELAYOUT_VEB: van Emde Boas order. The tree is split recursively in a
+ *  top and bottom subtrees of half the height
+ */
+enum rb_relayout_order {
+	RB_RELAYOUT_INORDER = 0,
+	RB_RELAYOUT_BFS,
+	RB_RELAYOUT_VEB
+};
+
+/* maximum recursion depth of RB_RELAYOUT_VEB (log2 of the tree height) */
+#define RB_RELAYOUT_MAX_FRAMES 16
+
+/**
+ * struct rb_relayout_frame - subtree of the van Emde Boas order
+ * @top: root of the subtree
+ * @cursor: root of the currently processed bottom subtree
+ * @height: height of the subtree
+ * @depth: depth of @cursor below @top
+ * @state: 0 before, 1 directly after and 2 while iterating over bottom
+ *  subtrees
+ */
+struct rb_relayout_frame {
+	struct rb_node *top;
+	struct rb_node *cursor;
+	unsigned int height;
+	unsigned int depth;
+	int state;
+};
+
+/**
+ * struct rb_relayout - state of an incremental relayout
+ * @root: pointer to rb root of the tree
+ * @order: order in which the nodes are moved
+ * @move: function which moves the entry of a node to its new location
+ * @arg: second argument for @move
+ * @cursor: last moved node (RB_RELAYOUT_INORDER, RB_RELAYOUT_BFS)
+ * @depth: depth of @cursor (RB_RELAYOUT_BFS)
+ * @level: depth of the currently moved level (RB_RELAYOUT_BFS)
+ * @started: first node was already selected
+ * @done: all nodes were moved
+ * @frames: number of used entries in @frame (RB_RELAYOUT_VEB)
+ * @frame: stack of the subtrees (RB_RELAYOUT_VEB)
+ */
+struct rb_relayout {
+	struct rb_root *root;
+	enum rb_relayout_order order;
+	struct rb_node *(*move)(struct rb_node *node, void *arg);
+	void *arg;
+	struct rb_node *cursor;
+	unsigned int depth;
+	unsigned int level;
+	int started;
+	int done;
+	size_t frames;
+	struct rb_relayout_frame frame[RB_RELAYOUT_MAX_FRAMES];
+};
+
+#ifdef RB_STATS
+/**
+ * struct rb_stats - operation counters (only with RB_STATS)
+ * @insert: number of inserted nodes
+ * @erase: number of erased nodes
+ * @insert_path: number of nodes visited during insert rebalance
+ * @insert_rotate_left: right leaning 3-nodes rotated to the left
+ * @insert_rotate_right: two consecutive left red nodes rotated to the right
+ * @insert_color_flip: 4-nodes split into 2-nodes
+ * @erase_path: number of nodes visited during erase rebalance
+ * @erase_left_restructure: low left subtree fixed by restructure
+ * @erase_left_recolor_red: low left subtree fixed by recolor under red parent
+ * @erase_left_recolor_black: low left subtree recolored under black parent
+ * @erase_right_adjust_red: low right subtree fixed by restructure and adjust
+ * @erase_right_adjust_black: low right subtree fixed by adjust and recolor
+ * @erase_right_restructure: low right subtree fixed by restructure
+ * @erase_right_recolor_red: low right subtree fixed by recolor under red parent
+ * @erase_right_recolor_black: low right subtree recolored under black parent
+ *
+ * The counters are collected for each thread separately. The recolor under
+ * black parent cases don't finish the rebalance and continue at the parent.
+ */
+struct rb_stats {
+	unsigned long insert;
+	unsigned long erase;
+	unsigned long insert_path;
+	unsigned long insert_rotate_left;
+	unsigned long insert_rotate_right;
+	unsigned long insert_color_flip;
+	unsigned long erase_path;
+	unsigned long erase_left_restructure;
+	unsigned long erase_left_recolor_red;
+	unsigned long erase_left_recolor_black;
+	unsigned long erase_right_adjust_red;
+	unsigned long erase_right_adjust_black;
+	unsigned long erase_right_restructure;
+	unsigned long erase_right_recolor_red;
+	unsigned long erase_right_recolor_black;
+};
+#endif
+
+#ifdef RB_TRACE
+#ifndef RB_TRACE_SAMPLE_RATE
+/* default: sample latency of every 64th operation */
+#define RB_TRACE_SAMPLE_RATE 64
+#endif
+
+/* number of histogram buckets for 64 bit latencies */
+#define RB_LATENCY_BUCKETS 496
+
+/**
+ * enum rb_trace_op - operations with latency histogram (only with RB_TRACE)
+ * @RB_TRACE_INSERT: rb_insert (also via rb_insert_hint)
+ * @RB_TRACE_ERASE: rb_erase
+ * @RB_TRACE_NEXT: rb_next
+ * @RB_TRACE_OP_COUNT: number of traced operations
+ */
+enum rb_trace_op {
+	RB_TRACE_INSERT = 0,
+	RB_TRACE_ERASE,
+	RB_TRACE_NEXT,
+	RB_TRACE_OP_COUNT
+};
+
+/**
+ * struct rb_latency_hist - latency histogram (only with RB_TRACE)
+ * @count: number of samples for each bucket
+ *
+ * The buckets are logarithmic with linear sub-buckets. The smallest latency
+ * of a bucket can be retrieved via rb_latency_bucket_value.
+ */
+struct rb_latency_hist {
+	unsigned long count[RB_LATENCY_BUCKETS];
+};
+#endif
+
 /**
  * DEFINE_RBROOT - define tree root and initialize it
  * @root: name of the new object
  */
+#ifndef RB_RELATIVE_POINTERS
 #define DEFINE_RBROOT(root) \
 	struct rb_root root = { NULL }
+#else
+#define DEFINE_RBROOT(root) \
+	struct rb_root root = { 0 }
+#endif
+
+/**
+ * rb_link_get() - Get node of a link
+ * @link: pointer to a child link of a node or the node link of a root
+ *
+ * Return: node referenced by @link, NULL when @link is empty
+ */
+static __inline__ struct rb_node *rb_link_get(RB_LINK const *link)
+{
+#ifndef RB_RELATIVE_POINTERS
+	return *link;
+#else
+	if (!*link)
+		return NULL;
+
+	return (struct rb_node *)((const char *)link + *link);
+#endif
+}
+
+/**
+ * rb_link_set() - Let link reference a node
+ * @link: pointer to a child link of a node or the node link of a root
+ * @node: node which should be referenced, can be NULL
+ */
+static __inline__ void rb_link_set(RB_LINK *link, struct rb_node *node)
+{
+#ifndef RB_RELATIVE_POINTERS
+	*link = node;
+#else
+	if (!node)
+		*link = 0;
+	else
+		*link = (const char *)node - (const char *)link;
+#endif
+}
 
 /**
  * INIT_RB_ROOT() - Initialize empty tree
@@ -109,7 +344,7 @@ struct rb_root {
  */
 static __inline__ void INIT_RB_ROOT(struct rb_root *root)
 {
-	root->node = NULL;
+	rb_link_set(&root->node, NULL);
 }
 
 /**
@@ -131,7 +366,14 @@ static __inline__ int rb_empty(const struct rb_root *root)
  */
 static __inline__ struct rb_node *rb_parent(struct rb_node *node)
 {
-#ifndef RB_PARENT_COLOR_COMBINATION
+#if defined(RB_RELATIVE_POINTERS)
+	ptrdiff_t offset = node->parent_color & ~(ptrdiff_t)1;
+
+	if (!offset)
+		return NULL;
+
+	return (struct rb_node *)((char *)node + offset);
+#elif !defined(RB_PARENT_COLOR_COMBINATION)
 	return node->parent;
 #else
 	return (struct rb_node *)(node->parent_color & ~1lu);
@@ -146,21 +388,139 @@ static __inline__ struct rb_node *rb_parent(struct rb_node *node)
  */
 static __inline__ enum rb_node_color rb_color(const struct rb_node *node)
 {
-#ifndef RB_PARENT_COLOR_COMBINATION
+#if defined(RB_RELATIVE_POINTERS)
+	return (enum rb_node_color)(node->parent_color & 1);
+#elif !defined(RB_PARENT_COLOR_COMBINATION)
 	return node->color;
 #else
 	return (enum rb_node_color)(node->parent_color & 1lu);
 #endif
 }
 
+/**
+ * rb_left() - Get left child of node
+ * @node: pointer to the rb node
+ *
+ * Return: left child of @node, NULL when it has no left child
+ */
+static __inline__ struct rb_node *rb_left(const struct rb_node *node)
+{
+	return rb_link_get(&node->left);
+}
+
+/**
+ * rb_right() - Get right child of node
+ * @node: pointer to the rb node
+ *
+ * Return: right child of @node, NULL when it has no right child
+ */
+static __inline__ struct rb_node *rb_right(const struct rb_node *node)
+{
+	return rb_link_get(&node->right);
+}
+
+RBTREE_API
 void rb_insert(struct rb_node *node, struct rb_node *parent,
-	       struct rb_node **rb_link, struct rb_root *root);
+	       RB_LINK *rb_link, struct rb_root *root);
+RBTREE_API
+void rb_insert_hint(struct rb_node *node, struct rb_node *hint,
+		    struct rb_root *root,
+		    int (*cmp)(const struct rb_node *node1,
+			       const struct rb_node *node2));
+RBTREE_API
+void rb_build(struct rb_root *root, struct rb_node * const *nodes,
+	      size_t count);
+RBTREE_API
 void rb_erase(struct rb_node *node, struct rb_root *root);
+RBTREE_API
+struct rb_node *rb_erase_first(struct rb_node *node, struct rb_root *root);
+RBTREE_API
+void rb_replace_node(struct rb_node *old_node, struct rb_node *new_node,
+		     struct rb_root *root);
+
+RBTREE_API
+void rb_join(struct rb_root *root, struct rb_root *left, struct rb_node *node,
+	     struct rb_root *right);
+RBTREE_API
+struct rb_node *rb_split(struct rb_root *root, const struct rb_node *pivot,
+			 int (*cmp)(const struct rb_node *node1,
+				    const struct rb_node *node2),
+			 struct rb_root *left, struct rb_root *right);
 
+RBTREE_API
 struct rb_node *rb_first(const struct rb_root *root);
+RBTREE_API
 struct rb_node *rb_last(const struct rb_root *root);
+RBTREE_API
 struct rb_node *rb_next(struct rb_node *node);
+RBTREE_API
 struct rb_node *rb_prev(struct rb_node *node);
+RBTREE_API
+struct rb_node *rb_erase_next(struct rb_node *node, struct rb_root *root);
+RBTREE_API
+struct rb_node *rb_erase_prev(struct rb_node *node, struct rb_root *root);
+
+RBTREE_API
+void rb_minsert(struct rb_mnode *mnode, struct rb_root *root,
+		int (*cmp)(const struct rb_node *node1,
+			   const struct rb_node *node2));
+RBTREE_API
+void rb_merase(struct rb_mnode *mnode, struct rb_root *root);
+RBTREE_API
+struct rb_mnode *rb_mfirst(const struct rb_root *root);
+RBTREE_API
+struct rb_mnode *rb_mlast(const struct rb_root *root);
+RBTREE_API
+struct rb_mnode *rb_mnext(struct rb_mnode *mnode);
+RBTREE_API
+struct rb_mnode *rb_mprev(struct rb_mnode *mnode);
+
+RBTREE_API
+struct rb_node *rb_lower_bound_from(struct rb_node *node, const void *key,
+				    int (*cmp)(const void *key,
+					       const struct rb_node *node));
+RBTREE_API
+void rb_find_batch(const struct rb_root *root, const void * const *keys,
+		   struct rb_node **results, size_t count,
+		   int (*cmp)(const void *key, const struct rb_node *node));
+RBTREE_API
+void rb_lower_bound_batch(const struct rb_root *root, const void * const *keys,
+			  struct rb_node **results, size_t count,
+			  int (*cmp)(const void *key,
+				     const struct rb_node *node));
+
+RBTREE_API
+void rb_get_shape(const struct rb_root *root, struct rb_shape *shape);
+
+RBTREE_API
+void rb_relayout_init(struct rb_relayout *relayout, struct rb_root *root,
+		      enum rb_relayout_order order,
+		      struct rb_node *(*move)(struct rb_node *node, void *arg),
+		      void *arg);
+RBTREE_API
+int rb_relayout_step(struct rb_relayout *relayout, size_t budget);
+RBTREE_API
+void rb_relayout(struct rb_root *root, enum rb_relayout_order order,
+		 struct rb_node *(*move)(struct rb_node *node, void *arg),
+		 void *arg);
+
+#ifdef RB_STATS
+RBTREE_API
+void rb_stats_get(struct rb_stats *stats);
+RBTREE_API
+void rb_stats_reset(void);
+#endif
+
+#ifdef RB_TRACE
+RBTREE_API
+void rb_trace_set_sample_rate(unsigned int rate);
+RBTREE_API
+void rb_latency_get(enum rb_trace_op op, struct rb_latency_hist *hist);
+RBTREE_API
+void rb_latency_reset(void);
+RBTREE_API
+unsigned long rb_latency_bucket_value(size_t bucket);
+#endif
 
 /**
  * rb_entry() - Calculate address of entry that contains tree node
@@ -172,8 +532,42 @@ struct rb_node *rb_prev(struct rb_node *node);
  */
 #define rb_entry(node, type, member) container_of(node, type, member)
 
+/**
+ * rb_for_each_safe() - Iterate over tree which allows to erase nodes
+ * @node: rb node pointer used as loop cursor
+ * @next: rb node pointer which has to be set to the result of
+ *  rb_erase_next(@node, @root) when the loop body erases @node
+ * @root: pointer to rb root
+ *
+ * @next is set to @node before each iteration. The loop continues with
+ * rb_next(@node) when @next was not changed by the body. Otherwise, @node
+ * was erased (and maybe free'd) and the loop continues with @next.
+ */
+#define rb_for_each_safe(node, next, root) \
+	for ((node) = rb_first(root); \
+	     (node) && ((next) = (node), 1); \
+	     (node) = ((next) == (node)) ? rb_next(node) : (next))
+
+/**
+ * rb_for_each_reverse_safe() - Iterate backwards which allows to erase nodes
+ * @node: rb node pointer used as loop cursor
+ * @prev: rb node pointer which has to be set to the result of
+ *  rb_erase_prev(@node, @root) when the loop body erases @node
+ * @root: pointer to rb root
+ *
+ * See rb_for_each_safe for the handling of @prev.
+ */
+#define rb_for_each_reverse_safe(node, prev, root) \
+	for ((node) = rb_last(root); \
+	     (node) && ((prev) = (node), 1); \
+	     (node) = ((prev) == (node)) ? rb_prev(node) : (prev))
+
 #ifdef __cplusplus
 }
 #endif
 
+#ifdef RBTREE_INLINE
+#include "rbtree.c"
+#endif
+
 #endif /* __RBTREE_H__ */
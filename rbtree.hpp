@@ -0,0 +1,498 @@
+/* SPDX-License-Identifier: MIT */
+/* Minimal red-black-tree helper functions - C++ wrapper
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#ifndef __RBTREE_HPP__
+#define __RBTREE_HPP__
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include "rbtree.h"
+
+namespace rb {
+
+namespace detail {
+
+/**
+ * struct member_traits - conversion between entry and embedded rb node
+ * @T: type of the entry
+ * @Member: pointer to the struct rb_node member of @T
+ */
+template <class T, struct rb_node T::*Member>
+struct member_traits {
+	static struct rb_node *to_node(T *value)
+	{
+		return &(value->*Member);
+	}
+
+	static const struct rb_node *to_node(const T *value)
+	{
+		return &(value->*Member);
+	}
+
+	static T *to_value(const struct rb_node *node)
+	{
+		const char *ptr = reinterpret_cast<const char *>(node);
+
+		return reinterpret_cast<T *>(const_cast<char *>(ptr - offset()));
+	}
+
+	static std::ptrdiff_t offset()
+	{
+		/* only the address of the member is calculated - the storage is
+		 * never accessed and T is never constructed
+		 */
+		static union {
+			char data[sizeof(T)];
+			long double align_float;
+			void *align_ptr;
+		} storage;
+		const T *value = reinterpret_cast<const T *>(storage.data);
+		const char *member = reinterpret_cast<const char *>(&(value->*Member));
+
+		return member - storage.data;
+	}
+};
+
+/**
+ * struct enable_if_const_of - type @type only exists when @T is const @U
+ * @T: target type
+ * @U: source type
+ */
+template <class T, class U>
+struct enable_if_const_of {
+};
+
+template <class U>
+struct enable_if_const_of<const U, U> {
+	typedef void type;
+};
+
+} /* namespace detail */
+
+/**
+ * class tree_iterator - bidirectional iterator over the entries of a tree
+ * @T: type of the entry (const qualified for const_iterator)
+ * @Traits: conversion between entry and embedded rb node
+ *
+ * The end() iterator stores the root to allow the decrement to rb_last().
+ */
+template <class T, class Traits>
+class tree_iterator {
+public:
+	typedef std::bidirectional_iterator_tag iterator_category;
+	typedef T value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef T *pointer;
+	typedef T &reference;
+
+	tree_iterator() : node_(NULL), root_(NULL) {}
+
+	tree_iterator(struct rb_node *node, const struct rb_root *root)
+		: node_(node), root_(root) {}
+
+	/* allow conversion from iterator to const_iterator (but not back) */
+	template <class U>
+	tree_iterator(const tree_iterator<U, Traits> &other,
+		      typename detail::enable_if_const_of<T, U>::type * = NULL)
+		: node_(other.node()), root_(other.root()) {}
+
+	reference operator*() const
+	{
+		return *Traits::to_value(node_);
+	}
+
+	pointer operator->() const
+	{
+		return Traits::to_value(node_);
+	}
+
+	tree_iterator &operator++()
+	{
+		node_ = rb_next(node_);
+		return *this;
+	}
+
+	tree_iterator operator++(int)
+	{
+		tree_iterator old(*this);
+
+		node_ = rb_next(node_);
+		return old;
+	}
+
+	tree_iterator &operator--()
+	{
+		if (node_)
+			node_ = rb_prev(node_);
+		else
+			node_ = rb_last(root_);
+		return *this;
+	}
+
+	tree_iterator operator--(int)
+	{
+		tree_iterator old(*this);
+
+		--*this;
+		return old;
+	}
+
+	template <class U>
+	bool operator==(const tree_iterator<U, Traits> &other) const
+	{
+		return node_ == other.node();
+	}
+
+	template <class U>
+	bool operator!=(const tree_iterator<U, Traits> &other) const
+	{
+		return node_ != other.node();
+	}
+
+	struct rb_node *node() const
+	{
+		return node_;
+	}
+
+	const struct rb_root *root() const
+	{
+		return root_;
+	}
+
+private:
+	struct rb_node *node_;
+	const struct rb_root *root_;
+};
+
+/**
+ * class intrusive_tree - ordered set of entries with embedded rb node
+ * @T: type of the entry
+ * @Member: pointer to the struct rb_node member of @T
+ * @Compare: strict weak ordering of @T. It must also accept the key types
+ *  (in both argument positions) used for heterogeneous lookups
+ *
+ * The tree never allocates or frees entries. They are owned by the caller and
+ * must stay valid while they are linked in the tree. The comparator is a
+ * template parameter and can therefore be fully inlined in the tree descent.
+ */
+template <class T, struct rb_node T::*Member, class Compare = std::less<T> >
+class intrusive_tree {
+	typedef detail::member_traits<T, Member> traits;
+
+public:
+	typedef T value_type;
+	typedef T &reference;
+	typedef const T &const_reference;
+	typedef std::size_t size_type;
+	typedef Compare value_compare;
+	typedef tree_iterator<T, traits> iterator;
+	typedef tree_iterator<const T, traits> const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	intrusive_tree() : comp_(), size_(0)
+	{
+		INIT_RB_ROOT(&root_);
+	}
+
+	explicit intrusive_tree(const Compare &comp) : comp_(comp), size_(0)
+	{
+		INIT_RB_ROOT(&root_);
+	}
+
+	bool empty() const
+	{
+		return rb_empty(&root_);
+	}
+
+	size_type size() const
+	{
+		return size_;
+	}
+
+	iterator begin()
+	{
+		return iterator(rb_first(&root_), &root_);
+	}
+
+	const_iterator begin() const
+	{
+		return const_iterator(rb_first(&root_), &root_);
+	}
+
+	iterator end()
+	{
+		return iterator(NULL, &root_);
+	}
+
+	const_iterator end() const
+	{
+		return const_iterator(NULL, &root_);
+	}
+
+	reverse_iterator rbegin()
+	{
+		return reverse_iterator(end());
+	}
+
+	const_reverse_iterator rbegin() const
+	{
+		return const_reverse_iterator(end());
+	}
+
+	reverse_iterator rend()
+	{
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rend() const
+	{
+		return const_reverse_iterator(begin());
+	}
+
+	/**
+	 * iterator_to() - Get iterator for an entry linked in the tree
+	 * @value: entry in the tree
+	 *
+	 * Return: iterator pointing to @value
+	 */
+	iterator iterator_to(T &value)
+	{
+		return iterator(traits::to_node(&value), &root_);
+	}
+
+	/**
+	 * find() - Search entry equal to key
+	 * @key: key compatible with Compare
+	 *
+	 * Return: iterator to an equal entry, end() when no entry was found
+	 */
+	template <class K>
+	iterator find(const K &key)
+	{
+		return iterator(find_node(key), &root_);
+	}
+
+	template <class K>
+	const_iterator find(const K &key) const
+	{
+		return const_iterator(find_node(key), &root_);
+	}
+
+	/**
+	 * lower_bound() - Search first entry not smaller than key
+	 * @key: key compatible with Compare
+	 *
+	 * Return: iterator to the entry, end() when all entries are smaller
+	 */
+	template <class K>
+	iterator lower_bound(const K &key)
+	{
+		return iterator(lower_bound_node(key), &root_);
+	}
+
+	template <class K>
+	const_iterator lower_bound(const K &key) const
+	{
+		return const_iterator(lower_bound_node(key), &root_);
+	}
+
+	/**
+	 * upper_bound() - Search first entry larger than key
+	 * @key: key compatible with Compare
+	 *
+	 * Return: iterator to the entry, end() when no entry is larger
+	 */
+	template <class K>
+	iterator upper_bound(const K &key)
+	{
+		return iterator(upper_bound_node(key), &root_);
+	}
+
+	template <class K>
+	const_iterator upper_bound(const K &key) const
+	{
+		return const_iterator(upper_bound_node(key), &root_);
+	}
+
+	/**
+	 * insert_unique() - Link entry when no equal entry is in the tree
+	 * @value: entry to link
+	 *
+	 * Return: iterator to @value and true when it was linked. Iterator to the
+	 *  already linked equal entry and false otherwise
+	 */
+	std::pair<iterator, bool> insert_unique(T &value)
+	{
+		RB_LINK *rb_link = &root_.node;
+		struct rb_node *parent = NULL;
+		const T *cur;
+
+		while (rb_link_get(rb_link)) {
+			parent = rb_link_get(rb_link);
+			cur = traits::to_value(parent);
+
+			if (comp_(value, *cur))
+				rb_link = &parent->left;
+			else if (comp_(*cur, value))
+				rb_link = &parent->right;
+			else
+				return std::make_pair(iterator(parent, &root_), false);
+		}
+
+		rb_insert(traits::to_node(&value), parent, rb_link, &root_);
+		size_++;
+
+		return std::make_pair(iterator_to(value), true);
+	}
+
+	/**
+	 * insert_equal() - Link entry after all equal entries
+	 * @value: entry to link
+	 *
+	 * Return: iterator to @value
+	 */
+	iterator insert_equal(T &value)
+	{
+		RB_LINK *rb_link = &root_.node;
+		struct rb_node *parent = NULL;
+
+		while (rb_link_get(rb_link)) {
+			parent = rb_link_get(rb_link);
+
+			if (comp_(value, *traits::to_value(parent)))
+				rb_link = &parent->left;
+			else
+				rb_link = &parent->right;
+		}
+
+		rb_insert(traits::to_node(&value), parent, rb_link, &root_);
+		size_++;
+
+		return iterator_to(value);
+	}
+
+	/**
+	 * erase() - Unlink entry
+	 * @pos: iterator to the entry
+	 *
+	 * Return: iterator to the entry after @pos
+	 */
+	iterator erase(iterator pos)
+	{
+		struct rb_node *node = pos.node();
+		struct rb_node *next = rb_next(node);
+
+		rb_erase(node, &root_);
+		size_--;
+
+		return iterator(next, &root_);
+	}
+
+	void erase(T &value)
+	{
+		rb_erase(traits::to_node(&value), &root_);
+		size_--;
+	}
+
+	/**
+	 * clear() - Unlink all entries
+	 *
+	 * The entries are not modified and can be freed by the caller afterwards.
+	 */
+	void clear()
+	{
+		INIT_RB_ROOT(&root_);
+		size_ = 0;
+	}
+
+	struct rb_root *root()
+	{
+		return &root_;
+	}
+
+	const struct rb_root *root() const
+	{
+		return &root_;
+	}
+
+	value_compare value_comp() const
+	{
+		return comp_;
+	}
+
+private:
+	/* the root is referenced by the iterators and linked nodes */
+	intrusive_tree(const intrusive_tree &);
+	intrusive_tree &operator=(const intrusive_tree &);
+
+	template <class K>
+	struct rb_node *find_node(const K &key) const
+	{
+		struct rb_node *node = rb_link_get(&root_.node);
+		const T *cur;
+
+		while (node) {
+			cur = traits::to_value(node);
+
+			if (comp_(key, *cur))
+				node = rb_left(node);
+			else if (comp_(*cur, key))
+				node = rb_right(node);
+			else
+				return node;
+		}
+
+		return NULL;
+	}
+
+	template <class K>
+	struct rb_node *lower_bound_node(const K &key) const
+	{
+		struct rb_node *node = rb_link_get(&root_.node);
+		struct rb_node *result = NULL;
+
+		while (node) {
+			if (comp_(*traits::to_value(node), key)) {
+				node = rb_right(node);
+			} else {
+				result = node;
+				node = rb_left(node);
+			}
+		}
+
+		return result;
+	}
+
+	template <class K>
+	struct rb_node *upper_bound_node(const K &key) const
+	{
+		struct rb_node *node = rb_link_get(&root_.node);
+		struct rb_node *result = NULL;
+
+		while (node) {
+			if (comp_(key, *traits::to_value(node))) {
+				result = node;
+				node = rb_left(node);
+			} else {
+				node = rb_right(node);
+			}
+		}
+
+		return result;
+	}
+
+	struct rb_root root_;
+	Compare comp_;
+	size_type size_;
+};
+
+} /* namespace rb */
+
+#endif /* __RBTREE_HPP__ */
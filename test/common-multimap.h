@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: MIT */
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#ifndef __RBTREE_COMMON_MULTIMAP_H__
+#define __RBTREE_COMMON_MULTIMAP_H__
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-treevalidation.h"
+
+/**
+ * struct rbmitem - entry of a multimap test tree
+ * @i: key of the entry
+ * @id: insertion sequence number of the entry
+ * @mnode: multimap node of the entry
+ */
+struct rbmitem {
+	uint16_t i;
+	uint16_t id;
+	struct rb_mnode mnode;
+};
+
+static __inline__ int rbmitem_cmp(const struct rb_node *node1,
+				  const struct rb_node *node2)
+{
+	const struct rbmitem *item1 = rb_entry(node1, struct rbmitem, mnode.rb);
+	const struct rbmitem *item2 = rb_entry(node2, struct rbmitem, mnode.rb);
+
+	return cmpint(&item1->i, &item2->i);
+}
+
+/**
+ * check_multimap() - Validate multimap tree
+ * @root: pointer to rb root
+ * @entries: expected number of entries in the multimap
+ * @keys: expected number of distinct keys in the multimap
+ *
+ * Entries with the same key must be ordered by their @id.
+ */
+static __inline__ void check_multimap(const struct rb_root *root,
+				      size_t entries, size_t keys)
+{
+	const struct rbmitem *item;
+	const struct rbmitem *last = NULL;
+	struct rb_mnode *mnode;
+	struct rb_mnode *prev;
+	struct rb_node *node;
+	size_t count = 0;
+
+	check_depth(root);
+	check_llrb_nodes(root);
+
+	/* tree only contains the first entry of each key */
+	for (node = rb_first(root); node; node = rb_next(node)) {
+		item = rb_entry(node, struct rbmitem, mnode.rb);
+		assert(!last || last->i < item->i);
+		last = item;
+		count++;
+	}
+	assert(count == keys);
+
+	count = 0;
+	last = NULL;
+	for (mnode = rb_mfirst(root); mnode; mnode = rb_mnext(mnode)) {
+		item = rb_entry(mnode, struct rbmitem, mnode);
+		if (last) {
+			assert(last->i <= item->i);
+			assert(last->i < item->i || last->id < item->id);
+		}
+		last = item;
+		count++;
+	}
+	assert(count == entries);
+
+	for (mnode = rb_mlast(root); mnode; mnode = prev) {
+		prev = rb_mprev(mnode);
+		if (prev)
+			assert(rb_mnext(prev) == mnode);
+		else
+			assert(rb_mfirst(root) == mnode);
+		count--;
+	}
+	assert(count == 0);
+}
+
+#endif /* __RBTREE_COMMON_MULTIMAP_H__ */
@@ -10,58 +10,30 @@
 #include <stddef.h>
 
 #include "../rbtree.h"
+#include "../rbtree-prioqueue.h"
 #include "common.h"
+#include "common-treeops.h"
 
-struct rb_prioqueue {
-	struct rb_root root;
-	struct rb_node *min_node;
-};
-
-static __inline__ void rb_prioqueue_init(struct rb_prioqueue *queue)
+static __inline__ void rbitem_prioqueue_init(struct rb_prioqueue *queue)
 {
-	INIT_RB_ROOT(&queue->root);
-	queue->min_node = NULL;
+	rb_prioqueue_init(queue, rbitem_cmp);
 }
 
 static __inline__ void
-rb_prioqueue_insert(struct rb_prioqueue *queue, struct rbitem *new_entry)
+rbitem_prioqueue_insert(struct rb_prioqueue *queue, struct rbitem *new_entry)
 {
-	struct rb_node *parent = NULL;
-	struct rb_node **cur_nodep = &queue->root.node;
-	struct rbitem *cur_entry;
-	int isminimal = 1;
-
-	while (*cur_nodep) {
-		cur_entry = rb_entry(*cur_nodep, struct rbitem, rb);
-
-		parent = *cur_nodep;
-		if (cmpint(&new_entry->i, &cur_entry->i) <= 0) {
-			cur_nodep = &((*cur_nodep)->left);
-		} else {
-			cur_nodep = &((*cur_nodep)->right);
-			isminimal = 0;
-		}
-	}
-
-	if (isminimal)
-		queue->min_node = &new_entry->rb;
-
-	rb_insert(&new_entry->rb, parent, cur_nodep, &queue->root);
+	rb_prioqueue_insert(queue, &new_entry->rb);
 }
 
-static __inline__ struct rbitem *rb_prioqueue_pop(struct rb_prioqueue *queue)
+static __inline__ struct rbitem *
+rbitem_prioqueue_pop(struct rb_prioqueue *queue)
 {
-	struct rbitem *item;
+	struct rb_node *node = rb_prioqueue_pop(queue);
 
-	if (!queue->min_node)
+	if (!node)
 		return NULL;
 
-	item = rb_entry(queue->min_node, struct rbitem, rb);
-	queue->min_node = rb_next(queue->min_node);
-
-	rb_erase(&item->rb, &queue->root);
-
-	return item;
+	return rb_entry(node, struct rbitem, rb);
 }
 
 #endif /* __RBTREE_COMMON_PRIOQUEUE_H__ */
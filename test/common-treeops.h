@@ -13,21 +13,38 @@
 #include "../rbtree.h"
 #include "common.h"
 
+static __inline__ int rbitem_cmp(const struct rb_node *node1,
+				 const struct rb_node *node2)
+{
+	const struct rbitem *item1 = rb_entry(node1, struct rbitem, rb);
+	const struct rbitem *item2 = rb_entry(node2, struct rbitem, rb);
+
+	return cmpint(&item1->i, &item2->i);
+}
+
+static __inline__ int rbitem_cmpkey(const void *key,
+				    const struct rb_node *node)
+{
+	const struct rbitem *item = rb_entry(node, struct rbitem, rb);
+
+	return cmpint(key, &item->i);
+}
+
 static __inline__ void rbitem_insert(struct rb_root *root,
 				     struct rbitem *new_entry)
 {
 	struct rb_node *parent = NULL;
-	struct rb_node **cur_nodep = &root->node;
+	RB_LINK *cur_nodep = &root->node;
 	struct rbitem *cur_entry;
 
-	while (*cur_nodep) {
-		cur_entry = rb_entry(*cur_nodep, struct rbitem, rb);
+	while (rb_link_get(cur_nodep)) {
+		cur_entry = rb_entry(rb_link_get(cur_nodep), struct rbitem, rb);
 
-		parent = *cur_nodep;
+		parent = rb_link_get(cur_nodep);
 		if (cmpint(&new_entry->i, &cur_entry->i) <= 0)
-			cur_nodep = &((*cur_nodep)->left);
+			cur_nodep = &rb_link_get(cur_nodep)->left;
 		else
-			cur_nodep = &((*cur_nodep)->right);
+			cur_nodep = &rb_link_get(cur_nodep)->right;
 	}
 
 	rb_insert(&new_entry->rb, parent, cur_nodep, root);
@@ -35,21 +52,21 @@ static __inline__ void rbitem_insert(struct rb_root *root,
 
 static __inline__ struct rbitem *rbitem_find(struct rb_root *root, uint16_t x)
 {
-	struct rb_node **cur_nodep = &root->node;
+	RB_LINK *cur_nodep = &root->node;
 	struct rbitem *cur_entry;
 	int res;
 
-	while (*cur_nodep) {
-		cur_entry = rb_entry(*cur_nodep, struct rbitem, rb);
+	while (rb_link_get(cur_nodep)) {
+		cur_entry = rb_entry(rb_link_get(cur_nodep), struct rbitem, rb);
 
 		res = cmpint(&x, &cur_entry->i);
 		if (res == 0)
 			return cur_entry;
 
 		if (res < 0)
-			cur_nodep = &((*cur_nodep)->left);
+			cur_nodep = &rb_link_get(cur_nodep)->left;
 		else
-			cur_nodep = &((*cur_nodep)->right);
+			cur_nodep = &rb_link_get(cur_nodep)->right;
 	}
 
 	return NULL;
@@ -28,7 +28,7 @@ static __inline__ void printnode(const struct rb_node *node, size_t depth,
 
 	item = rb_entry(node, struct rbitem, rb);
 
-	printnode(node->right, depth+1, '/');
+	printnode(rb_right(node), depth+1, '/');
 
 	for (i = 0; i < depth; i++)
 		printf("     ");
@@ -40,13 +40,13 @@ static __inline__ void printnode(const struct rb_node *node, size_t depth,
 
 	printf("%03u\n", item->i);
 
-	printnode(node->left, depth+1, '\\');
+	printnode(rb_left(node), depth+1, '\\');
 
 }
 
 static __inline__ void printtree(const struct rb_root *root)
 {
-	printnode(root->node, 0, '*');
+	printnode(rb_link_get(&root->node), 0, '*');
 }
 
 static __inline__ void printnode_dot(const struct rb_node *node,
@@ -66,9 +66,9 @@ static __inline__ void printnode_dot(const struct rb_node *node,
 		color = "black";
 	printf("%03u [color=\"%s\"];\n", item->i, color);
 
-	if (node->left) {
-		citem = rb_entry(node->left, struct rbitem, rb);
-		if (rb_color(node->left) == RB_RED)
+	if (rb_left(node)) {
+		citem = rb_entry(rb_left(node), struct rbitem, rb);
+		if (rb_color(rb_left(node)) == RB_RED)
 			color = "red";
 		else
 			color = "black";
@@ -84,9 +84,9 @@ static __inline__ void printnode_dot(const struct rb_node *node,
 		(*nilcnt)++;
 	}
 
-	if (node->right) {
-		citem = rb_entry(node->right, struct rbitem, rb);
-		if (rb_color(node->right) == RB_RED)
+	if (rb_right(node)) {
+		citem = rb_entry(rb_right(node), struct rbitem, rb);
+		if (rb_color(rb_right(node)) == RB_RED)
 			color = "red";
 		else
 			color = "black";
@@ -102,8 +102,8 @@ static __inline__ void printnode_dot(const struct rb_node *node,
 		(*nilcnt)++;
 	}
 
-	printnode_dot(node->left, nilcnt);
-	printnode_dot(node->right, nilcnt);
+	printnode_dot(rb_left(node), nilcnt);
+	printnode_dot(rb_right(node), nilcnt);
 }
 
 static __inline__ void printtree_dot(const struct rb_root *root)
@@ -113,7 +113,7 @@ static __inline__ void printtree_dot(const struct rb_root *root)
 	printf("digraph G {\n");
 	printf("  graph [ordering=\"out\"];\n");
 
-	printnode_dot(root->node, &nilcnt);
+	printnode_dot(rb_link_get(&root->node), &nilcnt);
 
 	printf("}\n");
 }
@@ -33,7 +33,7 @@ static __inline__ void check_node_order(struct rb_node *node,
 
 	assert(rb_parent(node) == parent);
 
-	check_node_order(node->left, node, skiplist, pos, size);
+	check_node_order(rb_left(node), node, skiplist, pos, size);
 
 	while (*pos < size && skiplist[*pos])
 		(*pos)++;
@@ -43,7 +43,7 @@ static __inline__ void check_node_order(struct rb_node *node,
 	assert(item->i == *pos);
 	(*pos)++;
 
-	check_node_order(node->right, node, skiplist, pos, size);
+	check_node_order(rb_right(node), node, skiplist, pos, size);
 }
 
 static __inline__ void check_root_order(const struct rb_root *root,
@@ -51,7 +51,7 @@ static __inline__ void check_root_order(const struct rb_root *root,
 {
 	uint16_t pos = 0;
 
-	check_node_order(root->node, NULL, skiplist, &pos, size);
+	check_node_order(rb_link_get(&root->node), NULL, skiplist, &pos, size);
 
 	while (pos < size && skiplist[pos])
 		pos++;
@@ -69,8 +69,8 @@ get_min_max_node(const struct rb_node *node)
 	if (!node)
 		return depth;
 
-	depth_left = get_min_max_node(node->left);
-	depth_right = get_min_max_node(node->right);
+	depth_left = get_min_max_node(rb_left(node));
+	depth_right = get_min_max_node(rb_right(node));
 
 	/* count all nodes */
 	assert(depth_left.min * 2 >= depth_left.max);
@@ -111,7 +111,7 @@ get_min_max_node(const struct rb_node *node)
 static __inline__ struct min_max_depth
 get_min_max_root(const struct rb_root *root)
 {
-	return get_min_max_node(root->node);
+	return get_min_max_node(rb_link_get(&root->node));
 }
 
 static __inline__ void check_depth(const struct rb_root *root)
@@ -130,23 +130,23 @@ static __inline__ void check_llrb_node(const struct rb_node *node)
 
 	/* no two consecutive red */
 	if (rb_color(node) == RB_RED) {
-		assert(!node->left || rb_color(node->left) == RB_BLACK);
-		assert(!node->right || rb_color(node->right) == RB_BLACK);
+		assert(!rb_left(node) || rb_color(rb_left(node)) == RB_BLACK);
+		assert(!rb_right(node) || rb_color(rb_right(node)) == RB_BLACK);
 	}
 
 	/* left leaning red black */
-	assert(!node->right || rb_color(node->right) == RB_BLACK);
+	assert(!rb_right(node) || rb_color(rb_right(node)) == RB_BLACK);
 
-	check_llrb_node(node->left);
-	check_llrb_node(node->right);
+	check_llrb_node(rb_left(node));
+	check_llrb_node(rb_right(node));
 }
 
 static __inline__ void check_llrb_nodes(const struct rb_root *root)
 {
-	if (root->node)
-		assert(rb_color(root->node) == RB_BLACK);
+	if (rb_link_get(&root->node))
+		assert(rb_color(rb_link_get(&root->node)) == RB_BLACK);
 
-	check_llrb_node(root->node);
+	check_llrb_node(rb_link_get(&root->node));
 }
 
 #endif /* __RBTREE_COMMON_TREEVALIDATION_H__ */
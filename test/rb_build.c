@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-treeops.h"
+#include "common-treevalidation.h"
+
+static uint16_t values[1024];
+static uint16_t delete_items[ARRAY_SIZE(values)];
+static struct rbitem items[ARRAY_SIZE(values)];
+static struct rb_node *nodes[ARRAY_SIZE(values)];
+static uint8_t skiplist[ARRAY_SIZE(values)];
+
+int main(void)
+{
+	struct rb_root root;
+	size_t size;
+	size_t j;
+
+	for (j = 0; j < ARRAY_SIZE(values); j++) {
+		items[j].i = (uint16_t)j;
+		nodes[j] = &items[j].rb;
+	}
+
+	for (size = 0; size <= ARRAY_SIZE(values); size++) {
+		/* tree content is replaced */
+		INIT_RB_ROOT(&root);
+		rbitem_insert(&root, &items[ARRAY_SIZE(values) - 1]);
+
+		rb_build(&root, nodes, size);
+
+		memset(skiplist, 1, sizeof(skiplist));
+		memset(skiplist, 0, size);
+		check_root_order(&root, skiplist, ARRAY_SIZE(skiplist));
+		check_depth(&root);
+		check_llrb_nodes(&root);
+
+		/* only check some trees with modifications */
+		if (size % 61)
+			continue;
+
+		random_shuffle_array(delete_items,
+				     (uint16_t)ARRAY_SIZE(delete_items));
+		for (j = 0; j < ARRAY_SIZE(delete_items); j++) {
+			if (skiplist[delete_items[j]])
+				continue;
+
+			rb_erase(&items[delete_items[j]].rb, &root);
+			skiplist[delete_items[j]] = 1;
+
+			check_root_order(&root, skiplist,
+					 ARRAY_SIZE(skiplist));
+			check_depth(&root);
+			check_llrb_nodes(&root);
+		}
+		assert(rb_empty(&root));
+	}
+
+	return 0;
+}
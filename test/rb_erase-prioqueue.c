@@ -52,7 +52,7 @@ int main(void)
 		inserted = 0;
 		queuelen = 0;
 
-		rb_prioqueue_init(&queue);
+		rbitem_prioqueue_init(&queue);
 		while (inserted < ARRAY_SIZE(values) ||
 		       queuelen != 0) {
 
@@ -66,13 +66,13 @@ int main(void)
 				assert(item);
 
 				item->i = values[inserted];
-				rb_prioqueue_insert(&queue, item);
+				rbitem_prioqueue_insert(&queue, item);
 
 				valuequeue[queuelen] = values[inserted];
 				inserted++;
 				queuelen++;
 			} else {
-				item = rb_prioqueue_pop(&queue);
+				item = rbitem_prioqueue_pop(&queue);
 
 				if (queuelen) {
 					assert(item);
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-treeops.h"
+#include "common-treevalidation.h"
+
+static uint16_t values[256];
+static uint8_t skiplist[ARRAY_SIZE(values)];
+
+static struct rbitem items[ARRAY_SIZE(values)];
+
+int main(void)
+{
+	struct rb_root root;
+	struct rb_node *node;
+	struct rbitem *item;
+	size_t i, j;
+
+	for (i = 0; i < 256; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+		memset(skiplist, 1, sizeof(skiplist));
+
+		INIT_RB_ROOT(&root);
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			items[j].i = values[j];
+			rbitem_insert(&root, &items[j]);
+			skiplist[values[j]] = 0;
+		}
+
+		node = rb_first(&root);
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			assert(node);
+			item = rb_entry(node, struct rbitem, rb);
+			assert(item->i == j);
+
+			node = rb_erase_first(node, &root);
+			skiplist[j] = 1;
+
+			assert(node == rb_first(&root));
+			check_root_order(&root, skiplist, ARRAY_SIZE(skiplist));
+			check_depth(&root);
+			check_llrb_nodes(&root);
+		}
+		assert(!node);
+		assert(rb_empty(&root));
+	}
+
+	return 0;
+}
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-treeops.h"
+#include "common-treevalidation.h"
+
+static uint16_t values[256];
+static uint8_t skiplist[ARRAY_SIZE(values)];
+
+static struct rbitem items[ARRAY_SIZE(values)];
+
+int main(void)
+{
+	struct rb_root root;
+	struct rb_node *node;
+	struct rb_node *next;
+	struct rb_node *expected;
+	struct rbitem *item;
+	size_t visited;
+	size_t i, j;
+
+	for (i = 0; i < 256; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+		memset(skiplist, 1, sizeof(skiplist));
+
+		INIT_RB_ROOT(&root);
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			items[j].i = values[j];
+			rbitem_insert(&root, &items[j]);
+			skiplist[values[j]] = 0;
+		}
+
+		/* erase every node whose value is a multiple of (i % 7 + 1) */
+		visited = 0;
+		rb_for_each_safe(node, next, &root) {
+			item = rb_entry(node, struct rbitem, rb);
+			assert(item->i == visited);
+			visited++;
+
+			if (item->i % (i % 7 + 1))
+				continue;
+
+			expected = rb_next(node);
+			next = rb_erase_next(node, &root);
+			skiplist[item->i] = 1;
+
+			assert(next == expected);
+			check_root_order(&root, skiplist, ARRAY_SIZE(skiplist));
+			check_depth(&root);
+			check_llrb_nodes(&root);
+		}
+		assert(visited == ARRAY_SIZE(values));
+
+		/* erase all remaining nodes */
+		rb_for_each_safe(node, next, &root) {
+			item = rb_entry(node, struct rbitem, rb);
+			assert(!skiplist[item->i]);
+
+			expected = rb_next(node);
+			next = rb_erase_next(node, &root);
+			skiplist[item->i] = 1;
+
+			assert(next == expected);
+			assert(node != rb_first(&root));
+			check_root_order(&root, skiplist, ARRAY_SIZE(skiplist));
+			check_depth(&root);
+			check_llrb_nodes(&root);
+		}
+		assert(rb_empty(&root));
+	}
+
+	return 0;
+}
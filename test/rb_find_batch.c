@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-treeops.h"
+
+static uint16_t values[256];
+
+static struct rbitem items[ARRAY_SIZE(values)];
+
+static uint16_t keys[300];
+static const void *keyptrs[ARRAY_SIZE(keys)];
+static struct rb_node *results[ARRAY_SIZE(keys)];
+
+int main(void)
+{
+	struct rb_root root;
+	struct rbitem *item;
+	size_t i, j;
+
+	for (j = 0; j < ARRAY_SIZE(keys); j++)
+		keyptrs[j] = &keys[j];
+
+	INIT_RB_ROOT(&root);
+	rb_find_batch(&root, keyptrs, results, ARRAY_SIZE(keys),
+		      rbitem_cmpkey);
+	for (j = 0; j < ARRAY_SIZE(keys); j++)
+		assert(!results[j]);
+
+	for (i = 0; i < 256; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+
+		/* only even keys are in the tree */
+		INIT_RB_ROOT(&root);
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			items[j].i = values[j] * 2;
+			rbitem_insert(&root, &items[j]);
+		}
+
+		for (j = 0; j < ARRAY_SIZE(keys); j++)
+			keys[j] = get_unsigned16() % (ARRAY_SIZE(values) * 2);
+
+		/* use also incomplete groups */
+		rb_find_batch(&root, keyptrs, results, ARRAY_SIZE(keys) - i,
+			      rbitem_cmpkey);
+
+		for (j = 0; j < ARRAY_SIZE(keys) - i; j++) {
+			if (keys[j] % 2) {
+				assert(!results[j]);
+				continue;
+			}
+
+			assert(results[j]);
+			item = rb_entry(results[j], struct rbitem, rb);
+			assert(item->i == keys[j]);
+		}
+	}
+
+	return 0;
+}
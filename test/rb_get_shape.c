@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-treeops.h"
+#include "common-treevalidation.h"
+
+static uint16_t values[256];
+
+static struct rbitem items[ARRAY_SIZE(values)];
+
+int main(void)
+{
+	struct rb_root root;
+	struct rb_shape shape;
+	struct min_max_depth depths;
+	size_t i, j;
+
+	INIT_RB_ROOT(&root);
+	rb_get_shape(&root, &shape);
+	assert(shape.size == 0);
+	assert(shape.height == 0);
+	assert(shape.black_height == 0);
+
+	for (i = 0; i < 256; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+
+		INIT_RB_ROOT(&root);
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			items[j].i = values[j];
+			rbitem_insert(&root, &items[j]);
+
+			/* validation counts the NULL leaves as extra level */
+			depths = get_min_max_root(&root);
+			rb_get_shape(&root, &shape);
+			assert(shape.size == j + 1);
+			assert(shape.height + 1 == depths.max);
+			assert(shape.black_height + 1 == depths.black_max);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+/* use header-only mode - no rbtree.o is linked */
+#define RBTREE_INLINE
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-treeops.h"
+#include "common-treevalidation.h"
+
+static uint16_t values[256];
+static uint16_t delete_items[ARRAY_SIZE(values)];
+static uint8_t skiplist[ARRAY_SIZE(values)];
+
+int main(void)
+{
+	struct rb_root root;
+	struct rb_node *node;
+	struct rbitem *item;
+	size_t i, j;
+	uint16_t last;
+
+	for (i = 0; i < 256; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+		memset(skiplist, 1, sizeof(skiplist));
+
+		INIT_RB_ROOT(&root);
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			item = (struct rbitem *)malloc(sizeof(*item));
+			assert(item);
+
+			item->i = values[j];
+			rbitem_insert(&root, item);
+			skiplist[values[j]] = 0;
+		}
+
+		check_root_order(&root, skiplist,
+				 (uint16_t)ARRAY_SIZE(skiplist));
+		check_depth(&root);
+		check_llrb_nodes(&root);
+
+		j = 0;
+		for (node = rb_first(&root); node; node = rb_next(node)) {
+			item = rb_entry(node, struct rbitem, rb);
+			assert(item->i == j);
+			j++;
+		}
+		assert(j == ARRAY_SIZE(values));
+
+		last = (uint16_t)ARRAY_SIZE(values);
+		for (node = rb_last(&root); node; node = rb_prev(node)) {
+			item = rb_entry(node, struct rbitem, rb);
+			assert(item->i == last - 1);
+			last = item->i;
+		}
+		assert(last == 0);
+
+		random_shuffle_array(delete_items, (uint16_t)ARRAY_SIZE(delete_items));
+		for (j = 0; j < ARRAY_SIZE(delete_items); j++) {
+			item = rbitem_find(&root, delete_items[j]);
+
+			assert(item);
+			assert(item->i == delete_items[j]);
+
+			rb_erase(&item->rb, &root);
+			skiplist[item->i] = 1;
+			free(item);
+
+			check_root_order(&root, skiplist,
+					(uint16_t)ARRAY_SIZE(skiplist));
+			check_depth(&root);
+			check_llrb_nodes(&root);
+		}
+		assert(rb_empty(&root));
+	}
+
+	return 0;
+}
@@ -24,17 +24,17 @@ int main(void)
 	for (i = 0; i < 256; i++) {
 		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
 
-		rb_prioqueue_init(&queue);
+		rbitem_prioqueue_init(&queue);
 		for (j = 0; j < ARRAY_SIZE(values); j++) {
 			item = (struct rbitem *)malloc(sizeof(*item));
 			assert(item);
 
 			item->i = values[j];
-			rb_prioqueue_insert(&queue, item);
+			rbitem_prioqueue_insert(&queue, item);
 		}
 
 		for (j = 0; j < ARRAY_SIZE(values); j++) {
-			item = rb_prioqueue_pop(&queue);
+			item = rbitem_prioqueue_pop(&queue);
 			assert(item);
 			assert(item->i == j);
 
@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "../rbtree-parallel.h"
+#include "common.h"
+#include "common-treeops.h"
+#include "common-treevalidation.h"
+
+/**
+ * struct dupitem - entry with non-unique key
+ * @key: sort key
+ * @seq: insertion order of the entry
+ * @rb: tree node
+ */
+struct dupitem {
+	uint16_t key;
+	uint16_t seq;
+	struct rb_node rb;
+};
+
+static uint16_t values[16384];
+static struct rbitem items[ARRAY_SIZE(values)];
+static struct dupitem dupitems[ARRAY_SIZE(values)];
+static struct rb_node *nodes[ARRAY_SIZE(values)];
+static uint8_t skiplist[ARRAY_SIZE(values)];
+
+static const unsigned int thread_counts[] = { 0, 1, 2, 3, 8 };
+
+static const size_t tree_sizes[] = { 0, 1, 100, 5000, 16000 };
+
+static int dupitem_cmp(const struct rb_node *node1,
+		       const struct rb_node *node2)
+{
+	const struct dupitem *item1 = rb_entry(node1, struct dupitem, rb);
+	const struct dupitem *item2 = rb_entry(node2, struct dupitem, rb);
+
+	return cmpint(&item1->key, &item2->key);
+}
+
+static void test_unique(void)
+{
+	struct rb_root root;
+	size_t batch;
+	size_t start, end;
+	size_t i, j, k;
+	int ret;
+
+	for (i = 0; i < ARRAY_SIZE(tree_sizes); i++) {
+		for (batch = 0; batch <= ARRAY_SIZE(values) - tree_sizes[i];
+		     batch = batch * 3 + 1) {
+			random_shuffle_array(values,
+					     (uint16_t)ARRAY_SIZE(values));
+			memset(skiplist, 1, sizeof(skiplist));
+
+			INIT_RB_ROOT(&root);
+			for (j = 0; j < tree_sizes[i]; j++) {
+				items[values[j]].i = values[j];
+				rbitem_insert(&root, &items[values[j]]);
+				skiplist[values[j]] = 0;
+			}
+
+			/* batch is added in multiple unsorted parts */
+			for (k = 0; k < ARRAY_SIZE(thread_counts); k++) {
+				start = tree_sizes[i] + batch * k /
+					ARRAY_SIZE(thread_counts);
+				end = tree_sizes[i] + batch * (k + 1) /
+				      ARRAY_SIZE(thread_counts);
+
+				for (j = start; j < end; j++) {
+					items[values[j]].i = values[j];
+					nodes[j - start] = &items[values[j]].rb;
+					skiplist[values[j]] = 0;
+				}
+
+				ret = rb_insert_batch(&root, nodes, end - start,
+						      thread_counts[k],
+						      rbitem_cmp);
+				assert(ret == 0);
+
+				check_root_order(&root, skiplist,
+						 ARRAY_SIZE(skiplist));
+				check_depth(&root);
+				check_llrb_nodes(&root);
+			}
+		}
+	}
+}
+
+static void test_duplicates(void)
+{
+	const struct dupitem *item;
+	const struct dupitem *prev;
+	struct rb_node *node;
+	struct rb_root root;
+	size_t batch;
+	size_t i, j;
+	int ret;
+
+	for (i = 0; i < ARRAY_SIZE(tree_sizes); i++) {
+		for (batch = 1; batch <= ARRAY_SIZE(values) - tree_sizes[i];
+		     batch = batch * 5 + 1) {
+			INIT_RB_ROOT(&root);
+			for (j = 0; j < tree_sizes[i] + batch; j++) {
+				dupitems[j].key = get_unsigned16() % 64;
+				dupitems[j].seq = (uint16_t)j;
+			}
+
+			for (j = 0; j < tree_sizes[i]; j++)
+				rb_insert_hint(&dupitems[j].rb, NULL, &root,
+					       dupitem_cmp);
+
+			for (j = 0; j < batch; j++)
+				nodes[j] = &dupitems[tree_sizes[i] + j].rb;
+
+			ret = rb_insert_batch(&root, nodes, batch, 4,
+					      dupitem_cmp);
+			assert(ret == 0);
+			check_depth(&root);
+			check_llrb_nodes(&root);
+
+			/* equal keys are kept in insertion order */
+			prev = NULL;
+			j = 0;
+			for (node = rb_first(&root); node; node = rb_next(node)) {
+				item = rb_entry(node, struct dupitem, rb);
+				if (prev) {
+					assert(prev->key <= item->key);
+					if (prev->key == item->key)
+						assert(prev->seq < item->seq);
+				}
+
+				prev = item;
+				j++;
+			}
+			assert(j == tree_sizes[i] + batch);
+		}
+	}
+}
+
+int main(void)
+{
+	test_unique();
+	test_duplicates();
+
+	return 0;
+}
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-treeops.h"
+#include "common-treevalidation.h"
+
+static uint16_t values[256];
+
+static struct rbitem items[ARRAY_SIZE(values)];
+static uint8_t skiplist[ARRAY_SIZE(values)];
+
+static void insert_check(struct rb_root *root, size_t pos,
+			 struct rb_node *hint)
+{
+	rb_insert_hint(&items[pos].rb, hint, root, rbitem_cmp);
+	skiplist[items[pos].i] = 0;
+
+	check_root_order(root, skiplist, (uint16_t)ARRAY_SIZE(skiplist));
+	check_depth(root);
+	check_llrb_nodes(root);
+}
+
+int main(void)
+{
+	struct rb_root root;
+	struct rb_node *hint;
+	size_t i, j;
+
+	/* ascending with last inserted node as hint */
+	memset(skiplist, 1, sizeof(skiplist));
+	INIT_RB_ROOT(&root);
+	hint = NULL;
+	for (j = 0; j < ARRAY_SIZE(values); j++) {
+		items[j].i = (uint16_t)j;
+		insert_check(&root, j, hint);
+		hint = &items[j].rb;
+	}
+
+	/* descending with last inserted node as hint */
+	memset(skiplist, 1, sizeof(skiplist));
+	INIT_RB_ROOT(&root);
+	hint = NULL;
+	for (j = 0; j < ARRAY_SIZE(values); j++) {
+		items[j].i = (uint16_t)(ARRAY_SIZE(values) - j - 1);
+		insert_check(&root, j, hint);
+		hint = &items[j].rb;
+	}
+
+	/* random order with (mostly wrong) random hints */
+	for (i = 0; i < 256; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+		memset(skiplist, 1, sizeof(skiplist));
+
+		INIT_RB_ROOT(&root);
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			items[j].i = values[j];
+
+			if (j == 0)
+				hint = NULL;
+			else
+				hint = &items[get_unsigned16() % j].rb;
+
+			insert_check(&root, j, hint);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbtree.hpp"
+#include "common.h"
+#include "common-treevalidation.h"
+
+struct rbitem_less {
+	bool operator()(const struct rbitem &item1,
+			const struct rbitem &item2) const
+	{
+		return item1.i < item2.i;
+	}
+
+	bool operator()(uint16_t key, const struct rbitem &item) const
+	{
+		return key < item.i;
+	}
+
+	bool operator()(const struct rbitem &item, uint16_t key) const
+	{
+		return item.i < key;
+	}
+};
+
+typedef rb::intrusive_tree<struct rbitem, &rbitem::rb, rbitem_less> rbitem_tree;
+
+static uint16_t values[256];
+static uint16_t delete_items[ARRAY_SIZE(values)];
+static uint8_t skiplist[ARRAY_SIZE(values)];
+static struct rbitem items[ARRAY_SIZE(values)];
+static struct rbitem duplicates[ARRAY_SIZE(values)];
+
+/* overloads to check the implicit conversions of iterators at compile time */
+struct iterator_conversion {
+	static char to_iterator(rbitem_tree::iterator);
+	static long to_iterator(...);
+	static char to_const_iterator(rbitem_tree::const_iterator);
+};
+
+static void check_iterator_conversion(rbitem_tree &tree)
+{
+	rbitem_tree::iterator it = tree.begin();
+	rbitem_tree::const_iterator cit = it;
+
+	/* const_iterator must not give mutable access to the entries */
+	assert(sizeof(iterator_conversion::to_const_iterator(it)) ==
+	       sizeof(char));
+	assert(sizeof(iterator_conversion::to_iterator(cit)) == sizeof(long));
+	assert(sizeof(iterator_conversion::to_iterator(it)) == sizeof(char));
+
+	assert(cit == it);
+	assert(it == cit);
+	assert(cit == static_cast<const rbitem_tree &>(tree).begin());
+}
+
+static void check_iterators(const rbitem_tree &tree)
+{
+	rbitem_tree::const_iterator it;
+	rbitem_tree::const_reverse_iterator rit;
+	uint16_t last;
+	size_t count;
+
+	count = 0;
+	last = 0;
+	for (it = tree.begin(); it != tree.end(); ++it) {
+		assert(count == 0 || it->i > last);
+		assert(!skiplist[it->i]);
+		last = it->i;
+		count++;
+	}
+	assert(count == tree.size());
+
+	count = 0;
+	for (rit = tree.rbegin(); rit != tree.rend(); ++rit) {
+		assert(count == 0 || rit->i < last);
+		last = rit->i;
+		count++;
+	}
+	assert(count == tree.size());
+}
+
+int main(void)
+{
+	std::pair<rbitem_tree::iterator, bool> ret;
+	rbitem_tree::iterator it;
+	rbitem_tree tree;
+	uint16_t key;
+	size_t i, j;
+
+	for (i = 0; i < 256; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+		memset(skiplist, 1, sizeof(skiplist));
+
+		for (j = 0; j < ARRAY_SIZE(values); j += 2) {
+			items[j].i = values[j];
+			ret = tree.insert_unique(items[j]);
+			assert(ret.second);
+			assert(&*ret.first == &items[j]);
+			skiplist[values[j]] = 0;
+
+			/* second insert of same key must be rejected */
+			duplicates[j].i = values[j];
+			ret = tree.insert_unique(duplicates[j]);
+			assert(!ret.second);
+			assert(&*ret.first == &items[j]);
+		}
+		assert(tree.size() == ARRAY_SIZE(values) / 2);
+
+		check_root_order(tree.root(), skiplist,
+				 (uint16_t)ARRAY_SIZE(skiplist));
+		check_depth(tree.root());
+		check_llrb_nodes(tree.root());
+		check_iterators(tree);
+		check_iterator_conversion(tree);
+
+		for (key = 0; key < ARRAY_SIZE(values); key++) {
+			it = tree.find(key);
+			if (skiplist[key]) {
+				assert(it == tree.end());
+			} else {
+				assert(it != tree.end());
+				assert(it->i == key);
+			}
+
+			it = tree.lower_bound(key);
+			for (j = key; j < ARRAY_SIZE(values) && skiplist[j]; j++)
+				;
+			if (j == ARRAY_SIZE(values))
+				assert(it == tree.end());
+			else
+				assert(it->i == j);
+
+			it = tree.upper_bound(key);
+			for (j = key + 1; j < ARRAY_SIZE(values) && skiplist[j]; j++)
+				;
+			if (j == ARRAY_SIZE(values))
+				assert(it == tree.end());
+			else
+				assert(it->i == j);
+		}
+
+		/* last entry must be reachable from end() */
+		it = tree.end();
+		--it;
+		assert(&*it == tree.rbegin().operator->());
+
+		random_shuffle_array(delete_items, (uint16_t)ARRAY_SIZE(delete_items));
+		for (j = 0; j < ARRAY_SIZE(delete_items); j++) {
+			key = delete_items[j];
+			it = tree.find(key);
+			if (skiplist[key]) {
+				assert(it == tree.end());
+				continue;
+			}
+
+			assert(it != tree.end());
+			if (j % 2) {
+				it = tree.erase(it);
+				if (it != tree.end())
+					assert(it->i > key);
+			} else {
+				tree.erase(*it);
+			}
+			skiplist[key] = 1;
+
+			check_root_order(tree.root(), skiplist,
+					 (uint16_t)ARRAY_SIZE(skiplist));
+			check_depth(tree.root());
+			check_llrb_nodes(tree.root());
+		}
+		assert(tree.empty());
+		assert(tree.size() == 0);
+
+		/* equal keys are linked after each other */
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			items[j].i = (uint16_t)(values[j] % 16);
+			tree.insert_equal(items[j]);
+		}
+		assert(tree.size() == ARRAY_SIZE(values));
+		check_depth(tree.root());
+		check_llrb_nodes(tree.root());
+
+		j = 0;
+		for (it = tree.begin(); it != tree.end(); ++it) {
+			assert(it->i == j / 16);
+			j++;
+		}
+		tree.clear();
+		assert(tree.empty());
+	}
+
+	return 0;
+}
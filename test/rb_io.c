@@ -0,0 +1,261 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#ifndef _POSIX_C_SOURCE
+/* required for fileno and ftruncate */
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../rbtree.h"
+#include "../rbtree-io.h"
+#include "common.h"
+#include "common-treeops.h"
+#include "common-treevalidation.h"
+
+#define RECORD_SIZE 40
+#define SMALL_RECORD_SIZE 8
+
+static uint16_t values[32768];
+static struct rbitem items[ARRAY_SIZE(values)];
+static struct rbitem loaded[ARRAY_SIZE(values)];
+static uint8_t skiplist[ARRAY_SIZE(values)];
+
+/* number of records which can be decoded before decode fails */
+static size_t decode_limit;
+
+/**
+ * struct smallitem - item with a key which doesn't fit in uint16_t
+ * @rb: node in the tree
+ * @key: key of the item
+ */
+struct smallitem {
+	struct rb_node rb;
+	uint32_t key;
+};
+
+/* more small records than fit in a single buffer of rb_save */
+static struct smallitem small_items[300000];
+static struct smallitem small_loaded[ARRAY_SIZE(small_items)];
+static struct rb_node *small_nodes[ARRAY_SIZE(small_items)];
+
+static void encode(const struct rb_node *node, void *record, void *arg)
+{
+	const struct rbitem *item = rb_entry(node, struct rbitem, rb);
+	unsigned char *buf = (unsigned char *)record;
+
+	assert(arg == items);
+
+	memset(buf, item->i & 0xff, RECORD_SIZE);
+	buf[0] = (unsigned char)(item->i & 0xff);
+	buf[1] = (unsigned char)(item->i >> 8);
+}
+
+static struct rb_node *decode(const void *record, void *arg)
+{
+	const unsigned char *buf = (const unsigned char *)record;
+	uint16_t key = (uint16_t)(buf[0] | (buf[1] << 8));
+	size_t i;
+
+	assert(arg == loaded);
+
+	if (!decode_limit)
+		return NULL;
+	decode_limit--;
+
+	for (i = 2; i < RECORD_SIZE; i++)
+		assert(buf[i] == (key & 0xff));
+
+	assert(key < ARRAY_SIZE(loaded));
+	loaded[key].i = key;
+
+	return &loaded[key].rb;
+}
+
+static void encode_small(const struct rb_node *node, void *record, void *arg)
+{
+	const struct smallitem *item = rb_entry(node, struct smallitem, rb);
+	unsigned char *buf = (unsigned char *)record;
+	uint32_t key = item->key;
+	size_t i;
+
+	assert(arg == small_items);
+
+	for (i = 0; i < 4; i++) {
+		buf[i] = (unsigned char)(key >> (8 * i));
+		buf[i + 4] = (unsigned char)(buf[i] ^ 0xff);
+	}
+}
+
+static struct rb_node *decode_small(const void *record, void *arg)
+{
+	const unsigned char *buf = (const unsigned char *)record;
+	uint32_t key = 0;
+	size_t i;
+
+	assert(arg == small_loaded);
+
+	for (i = 0; i < 4; i++) {
+		assert((buf[i] ^ buf[i + 4]) == 0xff);
+		key |= (uint32_t)buf[i] << (8 * i);
+	}
+
+	assert(key < ARRAY_SIZE(small_loaded));
+	small_loaded[key].key = key;
+
+	return &small_loaded[key].rb;
+}
+
+static size_t count_nodes(const struct rb_root *root)
+{
+	struct rb_node *node;
+	size_t count = 0;
+
+	for (node = rb_first(root); node; node = rb_next(node))
+		count++;
+
+	return count;
+}
+
+static void check_tree(const struct rb_root *root)
+{
+	check_root_order(root, skiplist, ARRAY_SIZE(skiplist));
+	check_depth(root);
+	check_llrb_nodes(root);
+}
+
+static void test_small_records(void)
+{
+	struct rb_root root;
+	struct rb_root copy;
+	struct rb_node *node;
+	const struct smallitem *item;
+	FILE *file;
+	size_t i;
+	int fd;
+	int ret;
+
+	for (i = 0; i < ARRAY_SIZE(small_items); i++) {
+		small_items[i].key = (uint32_t)i;
+		small_nodes[i] = &small_items[i].rb;
+	}
+	rb_build(&root, small_nodes, ARRAY_SIZE(small_nodes));
+
+	file = tmpfile();
+	assert(file);
+	fd = fileno(file);
+
+	/* frames end close to the end of the buffer */
+	ret = rb_save(fd, &root, SMALL_RECORD_SIZE, encode_small, small_items);
+	assert(ret == 0);
+
+	assert(lseek(fd, 0, SEEK_SET) == 0);
+	ret = rb_load(fd, &copy, SMALL_RECORD_SIZE, decode_small,
+		      small_loaded);
+	assert(ret == 0);
+	check_depth(&copy);
+	check_llrb_nodes(&copy);
+
+	i = 0;
+	for (node = rb_first(&copy); node; node = rb_next(node)) {
+		item = rb_entry(node, struct smallitem, rb);
+		assert(item == &small_loaded[i]);
+		assert(item->key == i);
+		i++;
+	}
+	assert(i == ARRAY_SIZE(small_items));
+
+	fclose(file);
+}
+
+int main(void)
+{
+	static const size_t sizes[] = { 0, 1, 100, 5000, 32768 };
+	struct rb_root root;
+	struct rb_root copy;
+	size_t count;
+	FILE *file;
+	off_t len;
+	size_t i, j;
+	int fd;
+	int ret;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+		memset(skiplist, 1, sizeof(skiplist));
+
+		INIT_RB_ROOT(&root);
+		for (j = 0; j < sizes[i]; j++) {
+			items[values[j]].i = values[j];
+			rbitem_insert(&root, &items[values[j]]);
+			skiplist[values[j]] = 0;
+		}
+
+		file = tmpfile();
+		assert(file);
+		fd = fileno(file);
+
+		ret = rb_save(fd, &root, RECORD_SIZE, encode, items);
+		assert(ret == 0);
+
+		/* file is padded for O_DIRECT */
+		len = lseek(fd, 0, SEEK_END);
+		assert(len > 0);
+		assert(len % 4096 == 0);
+
+		/* complete tree */
+		assert(lseek(fd, 0, SEEK_SET) == 0);
+		decode_limit = sizes[i];
+		ret = rb_load(fd, &copy, RECORD_SIZE, decode, loaded);
+		assert(ret == 0);
+		assert(count_nodes(&copy) == sizes[i]);
+		check_tree(&copy);
+
+		/* record size must match */
+		assert(lseek(fd, 0, SEEK_SET) == 0);
+		ret = rb_load(fd, &copy, RECORD_SIZE + 1, decode, loaded);
+		assert(ret == -EINVAL);
+		assert(rb_empty(&copy));
+
+		if (!sizes[i]) {
+			fclose(file);
+			continue;
+		}
+
+		/* failed decode keeps decoded nodes in tree */
+		assert(lseek(fd, 0, SEEK_SET) == 0);
+		decode_limit = sizes[i] / 2;
+		ret = rb_load(fd, &copy, RECORD_SIZE, decode, loaded);
+		assert(ret == -ENOMEM);
+		assert(count_nodes(&copy) == sizes[i] / 2);
+		check_depth(&copy);
+		check_llrb_nodes(&copy);
+
+		/* truncated file */
+		count = (sizes[i] * RECORD_SIZE / 2) / RECORD_SIZE;
+		assert(ftruncate(fd, (off_t)(sizes[i] * RECORD_SIZE / 2)) == 0);
+		assert(lseek(fd, 0, SEEK_SET) == 0);
+		decode_limit = sizes[i];
+		ret = rb_load(fd, &copy, RECORD_SIZE, decode, loaded);
+		assert(ret == -EINVAL);
+		assert(count_nodes(&copy) <= count);
+		check_depth(&copy);
+		check_llrb_nodes(&copy);
+
+		fclose(file);
+	}
+
+	test_small_records();
+
+	return 0;
+}
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-treeops.h"
+#include "common-treevalidation.h"
+
+static uint16_t values[512];
+static struct rbitem items[ARRAY_SIZE(values)];
+static uint8_t skiplist[ARRAY_SIZE(values)];
+
+int main(void)
+{
+	struct rb_root left;
+	struct rb_root right;
+	struct rb_root root;
+	size_t middle, end;
+	size_t i, j;
+
+	for (i = 0; i < 2048; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+
+		/* trees with very different sizes are also joined */
+		end = get_unsigned16() % (ARRAY_SIZE(values) + 1);
+		if (!end)
+			continue;
+		middle = get_unsigned16() % end;
+		if (i % 4 == 0)
+			middle = get_unsigned16() % (middle + 1);
+
+		memset(skiplist, 1, sizeof(skiplist));
+		INIT_RB_ROOT(&left);
+		INIT_RB_ROOT(&right);
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			if (values[j] >= end)
+				continue;
+
+			items[values[j]].i = values[j];
+			skiplist[values[j]] = 0;
+
+			if (values[j] < middle)
+				rbitem_insert(&left, &items[values[j]]);
+			else if (values[j] > middle)
+				rbitem_insert(&right, &items[values[j]]);
+		}
+
+		if (i % 2)
+			rb_join(&root, &left, &items[middle].rb, &right);
+		else if (i % 3)
+			rb_join(&left, &left, &items[middle].rb, &right);
+		else
+			rb_join(&right, &left, &items[middle].rb, &right);
+
+		if (i % 2 == 0) {
+			if (i % 3)
+				rb_link_set(&root.node,
+					    rb_link_get(&left.node));
+			else
+				rb_link_set(&root.node,
+					    rb_link_get(&right.node));
+		} else {
+			assert(rb_empty(&left));
+			assert(rb_empty(&right));
+		}
+
+		check_root_order(&root, skiplist, ARRAY_SIZE(skiplist));
+		check_depth(&root);
+		check_llrb_nodes(&root);
+
+		/* joined tree can be modified */
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			if (values[j] >= end)
+				continue;
+
+			rb_erase(&items[values[j]].rb, &root);
+			skiplist[values[j]] = 1;
+
+			check_root_order(&root, skiplist,
+					 ARRAY_SIZE(skiplist));
+			check_depth(&root);
+			check_llrb_nodes(&root);
+		}
+		assert(rb_empty(&root));
+	}
+
+	return 0;
+}
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-treeops.h"
+
+static uint16_t values[256];
+
+static struct rbitem items[ARRAY_SIZE(values)];
+
+int main(void)
+{
+	struct rb_root root;
+	struct rb_node *node;
+	struct rb_node *finger;
+	struct rbitem *item;
+	size_t i, j;
+	uint16_t key;
+
+	for (i = 0; i < 256; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+
+		/* only even keys are in the tree */
+		INIT_RB_ROOT(&root);
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			items[j].i = values[j] * 2;
+			rbitem_insert(&root, &items[j]);
+		}
+
+		/* jump from random fingers to random keys */
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			finger = &items[get_unsigned16() % ARRAY_SIZE(items)].rb;
+			key = get_unsigned16() % (ARRAY_SIZE(values) * 2 + 2);
+
+			node = rb_lower_bound_from(finger, &key, rbitem_cmpkey);
+			if (key > (ARRAY_SIZE(values) - 1) * 2) {
+				assert(!node);
+				continue;
+			}
+
+			assert(node);
+			item = rb_entry(node, struct rbitem, rb);
+			assert(item->i == key + key % 2);
+		}
+
+		/* walk cursor over all entries */
+		finger = rb_first(&root);
+		for (key = 0; key <= (ARRAY_SIZE(values) - 1) * 2; key++) {
+			finger = rb_lower_bound_from(finger, &key,
+						     rbitem_cmpkey);
+			assert(finger);
+
+			item = rb_entry(finger, struct rbitem, rb);
+			assert(item->i == key + key % 2);
+		}
+	}
+
+	return 0;
+}
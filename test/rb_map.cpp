@@ -0,0 +1,304 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+#include "../rbtree-map.hpp"
+#include "common.h"
+#include "common-treevalidation.h"
+
+/* upstream resource which counts the outstanding allocations */
+class counting_resource : public std::pmr::memory_resource {
+public:
+	size_t allocations = 0;
+	size_t outstanding = 0;
+
+private:
+	void *do_allocate(size_t bytes, size_t alignment) override
+	{
+		allocations++;
+		outstanding++;
+		return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+
+	void do_deallocate(void *p, size_t bytes, size_t alignment) override
+	{
+		outstanding--;
+		std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+	{
+		return this == &other;
+	}
+};
+
+typedef rb::map<uint16_t, std::unique_ptr<uint16_t>> rbmap;
+
+static uint16_t values[256];
+static uint16_t delete_items[ARRAY_SIZE(values)];
+static uint8_t skiplist[ARRAY_SIZE(values)];
+
+static void check_map(const rbmap &map)
+{
+	uint16_t last = 0;
+	size_t count = 0;
+
+	check_depth(map.root());
+	check_llrb_nodes(map.root());
+
+	for (const auto &entry : map) {
+		assert(count == 0 || entry.first > last);
+		assert(!skiplist[entry.first]);
+		assert(*entry.second == entry.first);
+		last = entry.first;
+		count++;
+	}
+	assert(count == map.size());
+
+	for (auto it = map.rbegin(); it != map.rend(); ++it) {
+		assert(it->first <= last);
+		last = it->first;
+		count--;
+	}
+	assert(count == 0);
+}
+
+static void test_single_allocation(void)
+{
+	counting_resource upstream;
+	size_t i, j;
+
+	for (i = 0; i < 16; i++) {
+		rbmap map(&upstream);
+
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+		memset(skiplist, 1, sizeof(skiplist));
+		upstream.allocations = 0;
+
+		for (j = 0; j < ARRAY_SIZE(values); j += 2) {
+			auto ret = map.try_emplace(values[j],
+						   new uint16_t(values[j]));
+			assert(ret.second);
+			assert(ret.first->first == values[j]);
+			skiplist[values[j]] = 0;
+
+			/* existing key - nothing is allocated or constructed */
+			ret = map.try_emplace(values[j], nullptr);
+			assert(!ret.second);
+			assert(*ret.first->second == values[j]);
+		}
+		assert(map.size() == ARRAY_SIZE(values) / 2);
+		assert(upstream.allocations == map.size());
+		check_map(map);
+
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			auto it = map.find((uint16_t)j);
+
+			assert(map.contains((uint16_t)j) == !skiplist[j]);
+			if (skiplist[j]) {
+				assert(it == map.end());
+				continue;
+			}
+
+			assert(it != map.end());
+			assert(*it->second == j);
+			assert(map.lower_bound((uint16_t)j) == it);
+			assert(map.upper_bound((uint16_t)j) == std::next(it));
+		}
+
+		random_shuffle_array(delete_items, (uint16_t)ARRAY_SIZE(delete_items));
+		for (j = 0; j < ARRAY_SIZE(delete_items); j++) {
+			if (j % 2)
+				assert(map.erase(delete_items[j]) == !skiplist[delete_items[j]]);
+			else if (!skiplist[delete_items[j]])
+				map.erase(map.find(delete_items[j]));
+			skiplist[delete_items[j]] = 1;
+
+			check_map(map);
+		}
+		assert(map.empty());
+		assert(upstream.outstanding == 0);
+	}
+}
+
+static void test_extract_insert(void)
+{
+	std::pmr::unsynchronized_pool_resource pool;
+	rbmap map1(&pool);
+	rbmap map2(&pool);
+	uint16_t *value;
+	size_t j;
+
+	for (j = 0; j < ARRAY_SIZE(values); j++)
+		map1.emplace((uint16_t)j, std::make_unique<uint16_t>((uint16_t)j));
+
+	for (j = 0; j < ARRAY_SIZE(values); j += 2) {
+		auto nh = map1.extract((uint16_t)j);
+
+		assert(!nh.empty());
+		assert(nh.key() == j);
+		value = nh.mapped().get();
+
+		/* entry is moved without any copy of the value */
+		auto ret = map2.insert(std::move(nh));
+		assert(ret.inserted);
+		assert(ret.node.empty());
+		assert(ret.position->second.get() == value);
+	}
+	assert(map1.size() == ARRAY_SIZE(values) / 2);
+	assert(map2.size() == ARRAY_SIZE(values) / 2);
+	assert(map1.extract((uint16_t)0).empty());
+
+	/* key can be changed while extracted */
+	auto nh = map2.extract(map2.begin());
+	nh.key() = 2;
+	auto ret = map2.insert(std::move(nh));
+	assert(!ret.inserted);
+	assert(!ret.node.empty());
+	assert(ret.position->first == 2);
+	ret.node.key() = 1;
+	ret = map1.insert(std::move(ret.node));
+	assert(!ret.inserted);
+	ret.node.key() = 1000;
+	*ret.node.mapped() = 1000;
+	ret = map1.insert(std::move(ret.node));
+	assert(ret.inserted);
+	assert(*map1.at(1000) == 1000);
+
+	map2 = std::move(map1);
+	assert(map1.empty());
+	assert(map2.size() == ARRAY_SIZE(values) / 2 + 1);
+}
+
+static void test_move_other_resource(void)
+{
+	std::pmr::unsynchronized_pool_resource pool1;
+	std::pmr::unsynchronized_pool_resource pool2;
+	rbmap map1(&pool1);
+	rbmap map2(&pool2);
+	size_t j;
+
+	for (j = 0; j < ARRAY_SIZE(values); j++)
+		map1.emplace((uint16_t)j, std::make_unique<uint16_t>((uint16_t)j));
+	map2.emplace((uint16_t)1000, std::make_unique<uint16_t>(1000));
+
+	/* entries are reallocated from the resource of map2 */
+	map2 = std::move(map1);
+	assert(map1.empty());
+	assert(map2.size() == ARRAY_SIZE(values));
+	assert(map2.get_allocator().resource() == &pool2);
+	assert(map2.find(1000) == map2.end());
+	check_depth(map2.root());
+	check_llrb_nodes(map2.root());
+
+	j = 0;
+	for (auto &entry : map2) {
+		assert(entry.first == j);
+		assert(*entry.second == j);
+		j++;
+	}
+}
+
+/* comparator with state which selects the order */
+struct order_less {
+	bool descending;
+
+	bool operator()(uint16_t key1, uint16_t key2) const
+	{
+		return descending ? key1 > key2 : key1 < key2;
+	}
+};
+
+typedef rb::map<uint16_t, uint16_t, order_less> ordermap;
+
+static void check_order(const ordermap &map, bool descending)
+{
+	size_t j = 0;
+
+	check_depth(map.root());
+	check_llrb_nodes(map.root());
+	assert(map.key_comp().descending == descending);
+
+	for (auto &entry : map) {
+		if (descending)
+			assert(entry.first == ARRAY_SIZE(values) - 1 - j);
+		else
+			assert(entry.first == j);
+		assert(entry.second == entry.first);
+		assert(map.find(entry.first)->second == entry.first);
+		j++;
+	}
+	assert(j == ARRAY_SIZE(values));
+}
+
+static void test_move_comparator(void)
+{
+	std::pmr::unsynchronized_pool_resource pool1;
+	std::pmr::unsynchronized_pool_resource pool2;
+	size_t i, j;
+
+	/* same and different memory resource */
+	for (i = 0; i < 2; i++) {
+		ordermap map1(&pool1, order_less{ true });
+		ordermap map2(i ? &pool2 : &pool1, order_less{ false });
+
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+		for (j = 0; j < ARRAY_SIZE(values); j++)
+			map1.emplace(values[j], values[j]);
+		map2.emplace((uint16_t)1, (uint16_t)1);
+
+		/* the comparator is taken over together with the entries */
+		map2 = std::move(map1);
+		assert(map1.empty());
+		check_order(map2, true);
+
+		ordermap map3(std::move(map2));
+		assert(map2.empty());
+		check_order(map3, true);
+	}
+}
+
+static void test_monotonic(void)
+{
+	unsigned char buffer[64 * 1024];
+	std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+	rb::map<uint16_t, uint16_t> map(&arena);
+	size_t j;
+
+	random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+	for (j = 0; j < ARRAY_SIZE(values); j++)
+		map[values[j]] = (uint16_t)(values[j] * 2);
+
+	assert(map.size() == ARRAY_SIZE(values));
+	check_depth(map.root());
+	check_llrb_nodes(map.root());
+
+	j = 0;
+	for (auto &entry : map) {
+		assert(entry.first == j);
+		assert(entry.second == j * 2);
+		j++;
+	}
+}
+
+int main(void)
+{
+	test_single_allocation();
+	test_extract_insert();
+	test_move_other_resource();
+	test_move_comparator();
+	test_monotonic();
+
+	return 0;
+}
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-multimap.h"
+
+static uint16_t values[1024];
+static uint16_t delete_items[ARRAY_SIZE(values)];
+static size_t key_entries[ARRAY_SIZE(values)];
+
+static struct rbmitem items[ARRAY_SIZE(values)];
+
+int main(void)
+{
+	struct rb_root root;
+	size_t i, j;
+	size_t keys;
+	size_t distinct;
+	uint16_t key;
+
+	for (i = 0; i < 32; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+		keys = 1 + i * i;
+		memset(key_entries, 0, sizeof(key_entries));
+
+		INIT_RB_ROOT(&root);
+		distinct = 0;
+		for (j = 0; j < ARRAY_SIZE(items); j++) {
+			items[j].i = (uint16_t)(values[j] % keys);
+			items[j].id = (uint16_t)j;
+			rb_minsert(&items[j].mnode, &root, rbmitem_cmp);
+
+			if (!key_entries[items[j].i]++)
+				distinct++;
+		}
+		check_multimap(&root, ARRAY_SIZE(items), distinct);
+
+		/* remove first, middle and last entries of the chains */
+		random_shuffle_array(delete_items,
+				     (uint16_t)ARRAY_SIZE(delete_items));
+		for (j = 0; j < ARRAY_SIZE(delete_items); j++) {
+			key = items[delete_items[j]].i;
+			rb_merase(&items[delete_items[j]].mnode, &root);
+
+			if (!--key_entries[key])
+				distinct--;
+
+			if (j % 16 == 0 || j > ARRAY_SIZE(delete_items) - 16)
+				check_multimap(&root,
+					       ARRAY_SIZE(delete_items) - j - 1,
+					       distinct);
+		}
+		assert(rb_empty(&root));
+	}
+
+	return 0;
+}
@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-multimap.h"
+
+static uint16_t values[256];
+
+static struct rbmitem items[ARRAY_SIZE(values) * 4];
+
+int main(void)
+{
+	struct rb_shape shape;
+	struct rb_root root;
+	size_t i, j;
+	size_t keys;
+
+	for (i = 0; i < 64; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+		keys = i + 1;
+
+		/* keys are repeated in random order */
+		INIT_RB_ROOT(&root);
+		for (j = 0; j < ARRAY_SIZE(items); j++) {
+			items[j].i = values[j % ARRAY_SIZE(values)] % keys;
+			items[j].id = (uint16_t)j;
+			rb_minsert(&items[j].mnode, &root, rbmitem_cmp);
+		}
+		check_multimap(&root, ARRAY_SIZE(items), keys);
+
+		/* height only depends on the number of distinct keys */
+		rb_get_shape(&root, &shape);
+		assert(shape.size == keys);
+	}
+
+	return 0;
+}
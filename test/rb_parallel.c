@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "../rbtree-parallel.h"
+#include "common.h"
+#include "common-treeops.h"
+
+static uint16_t values[4096];
+static struct rbitem items[ARRAY_SIZE(values)];
+static uint8_t visited[ARRAY_SIZE(values)];
+
+static const unsigned int thread_counts[] = { 0, 1, 2, 3, 8 };
+
+/**
+ * struct ordered_acc - accumulator which detects out-of-order combination
+ * @count: number of accumulated nodes
+ * @first: smallest key
+ * @last: largest key
+ * @sorted: all keys were accumulated in ascending order
+ * @sum: sum of all keys
+ */
+struct ordered_acc {
+	size_t count;
+	uint16_t first;
+	uint16_t last;
+	int sorted;
+	uint32_t sum;
+};
+
+static void visit(struct rb_node *node, void *arg)
+{
+	struct rbitem *item = rb_entry(node, struct rbitem, rb);
+
+	assert(arg == visited);
+	visited[item->i]++;
+}
+
+static void acc_init(void *acc, void *arg)
+{
+	struct ordered_acc *a = (struct ordered_acc *)acc;
+
+	assert(arg == visited);
+	memset(a, 0, sizeof(*a));
+	a->sorted = 1;
+}
+
+static void acc_accumulate(void *acc, struct rb_node *node, void *arg)
+{
+	struct ordered_acc *a = (struct ordered_acc *)acc;
+	struct rbitem *item = rb_entry(node, struct rbitem, rb);
+
+	assert(arg == visited);
+	if (a->count == 0)
+		a->first = item->i;
+	else if (item->i <= a->last)
+		a->sorted = 0;
+
+	a->last = item->i;
+	a->sum += item->i;
+	a->count++;
+}
+
+static void acc_combine(void *acc, const void *next, void *arg)
+{
+	struct ordered_acc *a = (struct ordered_acc *)acc;
+	const struct ordered_acc *n = (const struct ordered_acc *)next;
+
+	assert(arg == visited);
+	if (n->count == 0)
+		return;
+
+	if (a->count == 0) {
+		*a = *n;
+		return;
+	}
+
+	if (!n->sorted || n->first <= a->last)
+		a->sorted = 0;
+
+	a->last = n->last;
+	a->sum += n->sum;
+	a->count += n->count;
+}
+
+static const struct rb_reduce_ops ordered_ops = {
+	sizeof(struct ordered_acc),
+	acc_init,
+	acc_accumulate,
+	acc_combine,
+};
+
+int main(void)
+{
+	struct ordered_acc result;
+	struct rb_root root;
+	uint32_t sum;
+	size_t size;
+	size_t i, j;
+	int ret;
+
+	for (size = 0; size <= ARRAY_SIZE(values); size = size * 2 + 1) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+
+		INIT_RB_ROOT(&root);
+		sum = 0;
+		for (j = 0; j < size; j++) {
+			items[j].i = values[j];
+			rbitem_insert(&root, &items[j]);
+			sum += values[j];
+		}
+
+		for (i = 0; i < ARRAY_SIZE(thread_counts); i++) {
+			memset(visited, 0, sizeof(visited));
+			ret = rb_parallel_for_each(&root, thread_counts[i], visit,
+						   visited);
+			assert(ret == 0);
+
+			for (j = 0; j < size; j++)
+				assert(visited[values[j]] == 1);
+			for (j = size; j < ARRAY_SIZE(values); j++)
+				assert(visited[values[j]] == 0);
+
+			ret = rb_parallel_reduce(&root, thread_counts[i],
+						 &ordered_ops, visited, &result);
+			assert(ret == 0);
+			assert(result.count == size);
+			assert(result.sorted);
+			assert(result.sum == sum);
+			if (size) {
+				assert(result.first == rb_entry(rb_first(&root), struct rbitem, rb)->i);
+				assert(result.last == rb_entry(rb_last(&root), struct rbitem, rb)->i);
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../rbtree.h"
+#include "../rbtree-prioqueue.h"
+#include "common.h"
+#include "common-prioqueue.h"
+#include "common-treevalidation.h"
+
+static uint16_t values[256];
+static struct rbitem items[ARRAY_SIZE(values)];
+static uint8_t queued[ARRAY_SIZE(values)];
+
+static void check_queue(struct rb_prioqueue *queue)
+{
+	const struct rbitem *item;
+	struct rb_node *node;
+	size_t count = 0;
+	size_t expected = 0;
+	uint16_t last = 0;
+	size_t i;
+
+	check_depth(&queue->root);
+	check_llrb_nodes(&queue->root);
+	assert(rb_prioqueue_peek(queue) == rb_first(&queue->root));
+
+	for (node = rb_first(&queue->root); node; node = rb_next(node)) {
+		item = rb_entry(node, struct rbitem, rb);
+		assert(item->i >= last);
+		assert(queued[item - items]);
+		last = item->i;
+		count++;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(queued); i++)
+		expected += queued[i];
+	assert(count == expected);
+}
+
+int main(void)
+{
+	struct rb_prioqueue queue;
+	struct rbitem *item;
+	size_t i, j;
+	uint16_t pos;
+
+	for (i = 0; i < 256; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+
+		rbitem_prioqueue_init(&queue);
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			items[j].i = (uint16_t)(values[j] * 4);
+			rbitem_prioqueue_insert(&queue, &items[j]);
+			queued[j] = 1;
+		}
+		check_queue(&queue);
+
+		/* small changes keep the order, large changes move nodes */
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			pos = (uint16_t)(get_unsigned16() % ARRAY_SIZE(items));
+			if (j % 2)
+				items[pos].i = (uint16_t)(items[pos].i + i % 3);
+			else
+				items[pos].i = get_unsigned16() % 1024;
+
+			rb_prioqueue_update(&queue, &items[pos].rb);
+			check_queue(&queue);
+		}
+
+		for (j = 0; j < ARRAY_SIZE(values) / 2; j++) {
+			pos = values[j];
+			rb_prioqueue_erase(&queue, &items[pos].rb);
+			queued[pos] = 0;
+			check_queue(&queue);
+		}
+
+		while ((item = rbitem_prioqueue_pop(&queue))) {
+			assert(queued[item - items]);
+			queued[item - items] = 0;
+			check_queue(&queue);
+		}
+	}
+
+	return 0;
+}
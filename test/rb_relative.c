@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-treeops.h"
+#include "common-treevalidation.h"
+
+/**
+ * struct arena - memory area which contains a complete tree
+ * @root: root of the tree
+ * @items: entries of the tree
+ */
+struct arena {
+	struct rb_root root;
+	struct rbitem items[256];
+};
+
+static struct arena arena1;
+static struct arena arena2;
+static uint16_t values[ARRAY_SIZE(arena1.items)];
+static uint16_t delete_items[ARRAY_SIZE(values)];
+static uint8_t skiplist[ARRAY_SIZE(values)];
+
+static void check_arena(struct arena *arena)
+{
+	struct rb_node *node;
+
+	check_root_order(&arena->root, skiplist, ARRAY_SIZE(skiplist));
+	check_depth(&arena->root);
+	check_llrb_nodes(&arena->root);
+
+	/* all links point inside of the arena */
+	for (node = rb_first(&arena->root); node; node = rb_next(node)) {
+		assert((char *)node >= (char *)arena->items);
+		assert((char *)node < (char *)arena + sizeof(*arena));
+	}
+}
+
+int main(void)
+{
+	struct rbitem *item;
+	size_t i, j;
+
+	for (i = 0; i < 256; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+		memset(skiplist, 1, sizeof(skiplist));
+
+		INIT_RB_ROOT(&arena1.root);
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			item = &arena1.items[values[j]];
+			item->i = values[j];
+			rbitem_insert(&arena1.root, item);
+			skiplist[values[j]] = 0;
+		}
+
+		random_shuffle_array(delete_items,
+				     (uint16_t)ARRAY_SIZE(delete_items));
+		for (j = 0; j < i; j++) {
+			rb_erase(&arena1.items[delete_items[j]].rb,
+				 &arena1.root);
+			skiplist[delete_items[j]] = 1;
+		}
+		check_arena(&arena1);
+
+		/* tree is usable at a different address without fixups */
+		memcpy(&arena2, &arena1, sizeof(arena2));
+		memset(&arena1, 0, sizeof(arena1));
+		check_arena(&arena2);
+
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			item = rbitem_find(&arena2.root, (uint16_t)j);
+			if (skiplist[j]) {
+				assert(!item);
+				continue;
+			}
+
+			assert(item == &arena2.items[j]);
+		}
+
+		for (j = i; j < ARRAY_SIZE(delete_items); j++) {
+			rb_erase(&arena2.items[delete_items[j]].rb,
+				 &arena2.root);
+			skiplist[delete_items[j]] = 1;
+			check_arena(&arena2);
+		}
+		assert(rb_empty(&arena2.root));
+	}
+
+	return 0;
+}
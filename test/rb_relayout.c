@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-treeops.h"
+#include "common-treevalidation.h"
+
+static uint16_t values[256];
+static uint16_t delete_items[ARRAY_SIZE(values)];
+static uint8_t skiplist[ARRAY_SIZE(values)];
+static uint16_t expected[ARRAY_SIZE(values)];
+static size_t expected_count;
+
+static struct rbitem items[ARRAY_SIZE(values)];
+static struct rbitem arena[ARRAY_SIZE(values)];
+static size_t arena_used;
+
+static struct rb_node *move_item(struct rb_node *node, void *arg)
+{
+	struct rbitem *item = rb_entry(node, struct rbitem, rb);
+	struct rbitem *copy = &((struct rbitem *)arg)[arena_used++];
+
+	assert(arena_used <= ARRAY_SIZE(arena));
+
+	copy->i = item->i;
+
+	/* old entry is not accessed anymore */
+	memset(item, 0xff, sizeof(*item));
+
+	return &copy->rb;
+}
+
+static void collect_level(struct rb_node *node, size_t depth,
+			  struct rb_node **level, size_t *count)
+{
+	if (!node)
+		return;
+
+	if (depth == 0) {
+		level[(*count)++] = node;
+		return;
+	}
+
+	collect_level(rb_left(node), depth - 1, level, count);
+	collect_level(rb_right(node), depth - 1, level, count);
+}
+
+static void expect_node(struct rb_node *node)
+{
+	expected[expected_count++] = rb_entry(node, struct rbitem, rb)->i;
+}
+
+static void expect_bfs(struct rb_root *root)
+{
+	struct rb_node *level[ARRAY_SIZE(values)];
+	size_t count;
+	size_t depth;
+	size_t i;
+
+	for (depth = 0; ; depth++) {
+		count = 0;
+		collect_level(rb_link_get(&root->node), depth, level, &count);
+		if (!count)
+			break;
+
+		for (i = 0; i < count; i++)
+			expect_node(level[i]);
+	}
+}
+
+static void expect_veb(struct rb_node *node, size_t height)
+{
+	struct rb_node *level[ARRAY_SIZE(values)];
+	size_t top_height;
+	size_t count = 0;
+	size_t i;
+
+	if (height == 1) {
+		expect_node(node);
+		return;
+	}
+
+	top_height = height / 2;
+	expect_veb(node, top_height);
+
+	collect_level(node, top_height, level, &count);
+	for (i = 0; i < count; i++)
+		expect_veb(level[i], height - top_height);
+}
+
+static void check_tree(struct rb_root *root)
+{
+	size_t j;
+
+	check_root_order(root, skiplist, ARRAY_SIZE(skiplist));
+	check_depth(root);
+	check_llrb_nodes(root);
+
+	for (j = 0; j < ARRAY_SIZE(values); j++)
+		assert(!!rbitem_find(root, (uint16_t)j) == !skiplist[j]);
+}
+
+int main(void)
+{
+	enum rb_relayout_order order;
+	struct rb_relayout relayout;
+	struct rb_shape shape;
+	struct rb_root root;
+	struct rb_node *node;
+	size_t budget;
+	size_t i, j;
+
+	for (i = 0; i < 256; i++) {
+		order = (enum rb_relayout_order)(i % 3);
+		budget = 1 + i % 17;
+
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+		memset(skiplist, 1, sizeof(skiplist));
+		INIT_RB_ROOT(&root);
+
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			items[j].i = values[j];
+			rbitem_insert(&root, &items[j]);
+			skiplist[values[j]] = 0;
+		}
+
+		random_shuffle_array(delete_items,
+				     (uint16_t)ARRAY_SIZE(delete_items));
+		for (j = 0; j < i; j++) {
+			rb_erase(&items[delete_items[j]].rb, &root);
+			skiplist[items[delete_items[j]].i] = 1;
+		}
+
+		expected_count = 0;
+		switch (order) {
+		case RB_RELAYOUT_INORDER:
+			for (node = rb_first(&root); node; node = rb_next(node))
+				expect_node(node);
+			break;
+		case RB_RELAYOUT_BFS:
+			expect_bfs(&root);
+			break;
+		case RB_RELAYOUT_VEB:
+			rb_get_shape(&root, &shape);
+			if (shape.size)
+				expect_veb(rb_link_get(&root.node),
+					   2 * shape.black_height);
+			break;
+		}
+		assert(expected_count == ARRAY_SIZE(values) - i);
+
+		/* tree stays usable between the steps */
+		arena_used = 0;
+		rb_relayout_init(&relayout, &root, order, move_item, arena);
+		while (rb_relayout_step(&relayout, budget))
+			check_tree(&root);
+		check_tree(&root);
+
+		assert(arena_used == expected_count);
+		for (j = 0; j < arena_used; j++)
+			assert(arena[j].i == expected[j]);
+		for (node = rb_first(&root); node; node = rb_next(node))
+			assert(rb_entry(node, struct rbitem, rb) < &arena[j]);
+
+		/* one shot relayout back to the original array */
+		arena_used = 0;
+		rb_relayout(&root, RB_RELAYOUT_INORDER, move_item, items);
+		check_tree(&root);
+		assert(arena_used == expected_count);
+		for (j = 1; j < arena_used; j++)
+			assert(items[j - 1].i < items[j].i);
+	}
+
+	return 0;
+}
@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-treeops.h"
+#include "common-treevalidation.h"
+
+static uint16_t values[256];
+static uint16_t replace_items[ARRAY_SIZE(values)];
+static uint8_t skiplist[ARRAY_SIZE(values)];
+
+static struct rbitem items[2][ARRAY_SIZE(values)];
+
+int main(void)
+{
+	struct rb_shape shape_before;
+	struct rb_shape shape;
+	struct rb_root root;
+	struct rbitem *old_item;
+	struct rbitem *new_item;
+	size_t i, j;
+	size_t pos;
+	size_t side;
+
+	for (i = 0; i < 256; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+		memset(skiplist, 1, sizeof(skiplist));
+
+		INIT_RB_ROOT(&root);
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			items[0][j].i = values[j];
+			rbitem_insert(&root, &items[0][j]);
+			skiplist[values[j]] = 0;
+		}
+		rb_get_shape(&root, &shape_before);
+
+		/* move entries between both arrays, some multiple times */
+		random_shuffle_array(replace_items,
+				     (uint16_t)ARRAY_SIZE(replace_items));
+		for (j = 0; j < i * 2; j++) {
+			pos = replace_items[j % ARRAY_SIZE(replace_items)];
+			side = (j / ARRAY_SIZE(values)) % 2;
+			old_item = &items[side][pos];
+			new_item = &items[!side][pos];
+
+			new_item->i = old_item->i;
+			rb_replace_node(&old_item->rb, &new_item->rb, &root);
+			memset(old_item, 0xff, sizeof(*old_item));
+
+			assert(rbitem_find(&root, new_item->i) == new_item);
+			check_root_order(&root, skiplist, ARRAY_SIZE(skiplist));
+			check_depth(&root);
+			check_llrb_nodes(&root);
+		}
+
+		/* the shape of the tree is not modified */
+		rb_get_shape(&root, &shape);
+		assert(shape.size == shape_before.size);
+		assert(shape.height == shape_before.height);
+		assert(shape.black_height == shape_before.black_height);
+	}
+
+	return 0;
+}
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "../rbtree-parallel.h"
+#include "common.h"
+#include "common-treeops.h"
+#include "common-treevalidation.h"
+
+static uint16_t values[4096];
+static struct rbitem items_a[ARRAY_SIZE(values)];
+static struct rbitem items_b[ARRAY_SIZE(values)];
+static uint8_t in_a[ARRAY_SIZE(values)];
+static uint8_t in_b[ARRAY_SIZE(values)];
+static uint8_t dropped_a[ARRAY_SIZE(values)];
+static uint8_t dropped_b[ARRAY_SIZE(values)];
+static uint8_t skiplist[ARRAY_SIZE(values)];
+
+static const unsigned int thread_counts[] = { 0, 1, 2, 3, 8 };
+
+enum set_op {
+	SET_UNION,
+	SET_INTERSECTION,
+	SET_DIFFERENCE,
+	SET_OP_COUNT
+};
+
+static void drop(struct rb_node *node, void *arg)
+{
+	struct rbitem *item = rb_entry(node, struct rbitem, rb);
+
+	assert(arg == items_a);
+
+	if (item == &items_a[item->i])
+		dropped_a[item->i]++;
+	else
+		dropped_b[item->i]++;
+}
+
+static void fill_tree(struct rb_root *root, struct rbitem *items,
+		      uint8_t *in_tree, unsigned int permille)
+{
+	size_t j;
+
+	random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+
+	INIT_RB_ROOT(root);
+	for (j = 0; j < ARRAY_SIZE(values); j++) {
+		in_tree[values[j]] = get_unsigned16() % 1000 < permille;
+		if (!in_tree[values[j]])
+			continue;
+
+		items[values[j]].i = values[j];
+		rbitem_insert(root, &items[values[j]]);
+	}
+}
+
+static void run_op(enum set_op op, unsigned int threads,
+		   unsigned int permille_a, unsigned int permille_b)
+{
+	struct rb_root a;
+	struct rb_root b;
+	int in_result;
+	size_t j;
+
+	fill_tree(&a, items_a, in_a, permille_a);
+	fill_tree(&b, items_b, in_b, permille_b);
+	memset(dropped_a, 0, sizeof(dropped_a));
+	memset(dropped_b, 0, sizeof(dropped_b));
+
+	switch (op) {
+	case SET_UNION:
+		rb_union(&a, &b, threads, rbitem_cmp, drop, items_a);
+		break;
+	case SET_INTERSECTION:
+		rb_intersection(&a, &b, threads, rbitem_cmp, drop, items_a);
+		break;
+	case SET_DIFFERENCE:
+		rb_difference(&a, &b, threads, rbitem_cmp, drop, items_a);
+		break;
+	case SET_OP_COUNT:
+		assert(0);
+		break;
+	}
+
+	assert(rb_empty(&b));
+
+	for (j = 0; j < ARRAY_SIZE(values); j++) {
+		switch (op) {
+		case SET_UNION:
+			in_result = in_a[j] || in_b[j];
+			break;
+		case SET_INTERSECTION:
+			in_result = in_a[j] && in_b[j];
+			break;
+		case SET_DIFFERENCE:
+		default:
+			in_result = in_a[j] && !in_b[j];
+			break;
+		}
+
+		skiplist[j] = !in_result;
+
+		/* nodes of the first tree are preferred in the result */
+		if (in_result && in_a[j]) {
+			assert(!dropped_a[j]);
+			assert(dropped_b[j] == in_b[j]);
+		} else if (in_result) {
+			assert(!dropped_b[j]);
+		} else {
+			assert(dropped_a[j] == in_a[j]);
+			assert(dropped_b[j] == in_b[j]);
+		}
+	}
+
+	check_root_order(&a, skiplist, ARRAY_SIZE(skiplist));
+	check_depth(&a);
+	check_llrb_nodes(&a);
+}
+
+int main(void)
+{
+	static const unsigned int permille[] = { 0, 1, 50, 500, 1000 };
+	size_t i, j, k;
+	int op;
+
+	for (op = 0; op < SET_OP_COUNT; op++) {
+		for (i = 0; i < ARRAY_SIZE(permille); i++) {
+			for (j = 0; j < ARRAY_SIZE(permille); j++) {
+				k = (i + j) % ARRAY_SIZE(thread_counts);
+				run_op((enum set_op)op, thread_counts[k],
+				       permille[i], permille[j]);
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-treeops.h"
+#include "common-treevalidation.h"
+
+static uint16_t values[512];
+static struct rbitem items[ARRAY_SIZE(values)];
+static uint8_t skiplist_left[ARRAY_SIZE(values)];
+static uint8_t skiplist_right[ARRAY_SIZE(values)];
+
+static void check_tree(const struct rb_root *root, const uint8_t *skiplist)
+{
+	check_root_order(root, skiplist, ARRAY_SIZE(values));
+	check_depth(root);
+	check_llrb_nodes(root);
+}
+
+int main(void)
+{
+	struct rbitem pivot;
+	struct rb_root left;
+	struct rb_root right;
+	struct rb_root root;
+	struct rb_node *found;
+	size_t i, j;
+
+	for (i = 0; i < 1024; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+
+		/* only even keys are in the tree */
+		INIT_RB_ROOT(&root);
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			if (values[j] % 2)
+				continue;
+
+			items[values[j]].i = values[j];
+			rbitem_insert(&root, &items[values[j]]);
+		}
+
+		pivot.i = (uint16_t)(i % (ARRAY_SIZE(values) + 2));
+		if (i % 2)
+			found = rb_split(&root, &pivot.rb, rbitem_cmp, &left,
+					 &right);
+		else
+			found = rb_split(&root, &pivot.rb, rbitem_cmp, &root,
+					 &right);
+
+		if (i % 2)
+			assert(rb_empty(&root));
+		else
+			rb_link_set(&left.node, rb_link_get(&root.node));
+
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			skiplist_left[j] = (j % 2) || j >= pivot.i;
+			skiplist_right[j] = (j % 2) || j <= pivot.i;
+		}
+
+		check_tree(&left, skiplist_left);
+		check_tree(&right, skiplist_right);
+
+		if (pivot.i % 2 || pivot.i >= ARRAY_SIZE(values)) {
+			assert(!found);
+			continue;
+		}
+
+		assert(found == &items[pivot.i].rb);
+		assert(!rb_left(found));
+		assert(!rb_right(found));
+
+		/* split trees can be joined again */
+		rb_join(&root, &left, found, &right);
+		for (j = 0; j < ARRAY_SIZE(values); j++)
+			skiplist_left[j] = j % 2;
+		check_tree(&root, skiplist_left);
+	}
+
+	return 0;
+}
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-treeops.h"
+
+static uint16_t values[256];
+static uint16_t delete_items[ARRAY_SIZE(values)];
+
+static struct rbitem items[ARRAY_SIZE(values)];
+
+int main(void)
+{
+	struct rb_root root;
+	struct rb_stats stats;
+	struct rbitem *item;
+	unsigned long erase_cases;
+	unsigned long erase_done;
+	size_t i, j;
+
+	rb_stats_reset();
+	rb_stats_get(&stats);
+	assert(stats.insert == 0);
+	assert(stats.erase == 0);
+
+	for (i = 0; i < 256; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+		rb_stats_reset();
+
+		INIT_RB_ROOT(&root);
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			items[j].i = values[j];
+			rbitem_insert(&root, &items[j]);
+		}
+
+		rb_stats_get(&stats);
+		assert(stats.insert == ARRAY_SIZE(values));
+		assert(stats.erase == 0);
+		assert(stats.insert_path >= stats.insert);
+		assert(stats.insert_rotate_left > 0);
+		assert(stats.insert_color_flip > 0);
+		assert(stats.erase_path == 0);
+
+		random_shuffle_array(delete_items,
+				     (uint16_t)ARRAY_SIZE(delete_items));
+		for (j = 0; j < ARRAY_SIZE(delete_items); j++) {
+			item = rbitem_find(&root, delete_items[j]);
+			assert(item);
+
+			rb_erase(&item->rb, &root);
+		}
+		assert(rb_empty(&root));
+
+		rb_stats_get(&stats);
+		assert(stats.insert == ARRAY_SIZE(values));
+		assert(stats.erase == ARRAY_SIZE(values));
+
+		/* each rebalance ends with a case which isn't continued at
+		 * the parent or at the root
+		 */
+		erase_done = stats.erase_left_restructure +
+			     stats.erase_left_recolor_red +
+			     stats.erase_right_adjust_red +
+			     stats.erase_right_adjust_black +
+			     stats.erase_right_restructure +
+			     stats.erase_right_recolor_red;
+		erase_cases = erase_done + stats.erase_left_recolor_black +
+			      stats.erase_right_recolor_black;
+		assert(erase_cases == stats.erase_path);
+		assert(erase_done <= stats.erase);
+	}
+
+	return 0;
+}
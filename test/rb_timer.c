@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "../rbtree-timer.h"
+#include "common.h"
+#include "common-treevalidation.h"
+
+/**
+ * struct timeritem - timer with identifier
+ * @timer: timer in the timer queue
+ * @id: index in items
+ * @pending: timer was added and is not yet expired or deleted
+ */
+struct timeritem {
+	struct rb_timer timer;
+	uint16_t id;
+	uint8_t pending;
+};
+
+static uint16_t values[256];
+static struct timeritem items[ARRAY_SIZE(values)];
+
+/**
+ * struct expire_state - state of an rb_timer_expire run
+ * @queue: timer queue which is expired
+ * @now: current time of the run
+ * @last: deadline of the previous expired timer
+ * @rearm: add expired timers again with a deadline after @now
+ */
+struct expire_state {
+	struct rb_timer_queue *queue;
+	uint64_t now;
+	uint64_t last;
+	int rearm;
+};
+
+static void check_queue(struct rb_timer_queue *queue)
+{
+	const struct rb_timer *timer;
+	struct rb_node *node;
+	uint64_t last = 0;
+	size_t count = 0;
+	size_t pending = 0;
+	size_t i;
+
+	check_depth(&queue->root);
+	check_llrb_nodes(&queue->root);
+
+	node = rb_first(&queue->root);
+	if (node)
+		assert(rb_timer_peek(queue) ==
+		       rb_entry(node, struct rb_timer, rb));
+	else
+		assert(!rb_timer_peek(queue));
+
+	for (; node; node = rb_next(node)) {
+		timer = rb_entry(node, struct rb_timer, rb);
+		assert(timer->expires >= last);
+		last = timer->expires;
+		count++;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(items); i++)
+		pending += items[i].pending;
+	assert(count == pending);
+}
+
+static void expire_timer(struct rb_timer *timer, void *arg)
+{
+	struct timeritem *item = container_of(timer, struct timeritem, timer);
+	struct expire_state *state = (struct expire_state *)arg;
+
+	assert(item->pending);
+	assert(timer->expires <= state->now);
+	assert(timer->expires >= state->last);
+	state->last = timer->expires;
+
+	if (state->rearm)
+		rb_timer_add(state->queue, timer, state->now + 1 + item->id);
+	else
+		item->pending = 0;
+}
+
+static void test_expire(void)
+{
+	struct rb_timer_queue queue;
+	struct expire_state state;
+	const struct rb_timer *first;
+	size_t count;
+	size_t expected;
+	size_t i, j;
+	uint64_t now;
+
+	for (i = 0; i < 64; i++) {
+		rb_timer_queue_init(&queue, 0);
+		memset(items, 0, sizeof(items));
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			items[j].id = (uint16_t)j;
+			items[j].pending = 1;
+			rb_timer_add(&queue, &items[j].timer, values[j] / 4);
+			assert(items[j].timer.expires == values[j] / 4);
+		}
+		check_queue(&queue);
+		assert(rb_timer_peek(&queue)->expires == 0);
+
+		/* re-armed timers stay in the queue with later deadlines */
+		state.queue = &queue;
+		state.now = i / 2;
+		state.last = 0;
+		state.rearm = 1;
+		count = rb_timer_expire(&queue, state.now, expire_timer,
+					&state);
+		assert(count == 4 * (state.now + 1));
+		check_queue(&queue);
+		assert(rb_timer_peek(&queue)->expires > state.now);
+
+		state.rearm = 0;
+		for (now = state.now; rb_timer_peek(&queue); now += i + 1) {
+			first = rb_timer_peek(&queue);
+			expected = 0;
+			for (j = 0; j < ARRAY_SIZE(items); j++) {
+				if (items[j].pending &&
+				    items[j].timer.expires <= now)
+					expected++;
+			}
+
+			state.now = now;
+			state.last = 0;
+			count = rb_timer_expire(&queue, now, expire_timer,
+						&state);
+			assert(count == expected);
+			assert(!count || first->expires <= now);
+			check_queue(&queue);
+		}
+	}
+}
+
+static void test_fifo_slack(void)
+{
+	struct rb_timer_queue queue;
+	struct rb_node *node;
+	size_t i;
+
+	rb_timer_queue_init(&queue, 10);
+	memset(items, 0, sizeof(items));
+
+	rb_timer_add(&queue, &items[0].timer, 100);
+	rb_timer_add(&queue, &items[1].timer, 95);
+	assert(items[1].timer.expires == 100);
+	rb_timer_add(&queue, &items[2].timer, 89);
+	assert(items[2].timer.expires == 89);
+	rb_timer_add(&queue, &items[3].timer, 90);
+	assert(items[3].timer.expires == 100);
+	rb_timer_add(&queue, &items[4].timer, 101);
+	assert(items[4].timer.expires == 101);
+	assert(rb_timer_peek(&queue) == &items[2].timer);
+
+	/* timers with the same deadline are kept in insertion order */
+	node = rb_first(&queue.root);
+	assert(node == &items[2].timer.rb);
+	node = rb_next(node);
+	assert(node == &items[0].timer.rb);
+	node = rb_next(node);
+	assert(node == &items[1].timer.rb);
+	node = rb_next(node);
+	assert(node == &items[3].timer.rb);
+	node = rb_next(node);
+	assert(node == &items[4].timer.rb);
+
+	for (i = 0; i < 5; i++)
+		rb_timer_del(&queue, &items[i].timer);
+	assert(!rb_timer_peek(&queue));
+	assert(rb_empty(&queue.root));
+}
+
+static void test_mod(void)
+{
+	struct rb_timer_queue queue;
+	uint64_t expires;
+	size_t i, j;
+
+	for (i = 0; i < 64; i++) {
+		rb_timer_queue_init(&queue, 0);
+		memset(items, 0, sizeof(items));
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			items[j].pending = 1;
+			rb_timer_add(&queue, &items[j].timer, values[j] * 4);
+		}
+		check_queue(&queue);
+
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			expires = items[j].timer.expires;
+			if (j % 2)
+				expires += 1 + i % 3;
+			else
+				expires = values[(j + i) % ARRAY_SIZE(values)];
+
+			rb_timer_mod(&queue, &items[j].timer, expires);
+			assert(items[j].timer.expires == expires);
+			check_queue(&queue);
+		}
+
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			rb_timer_del(&queue, &items[values[j]].timer);
+			items[values[j]].pending = 0;
+			check_queue(&queue);
+		}
+	}
+}
+
+int main(void)
+{
+	test_expire();
+	test_fifo_slack();
+	test_mod();
+
+	return 0;
+}
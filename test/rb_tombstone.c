@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../rbtree.h"
+#include "../rbtree-tombstone.h"
+#include "common.h"
+#include "common-treevalidation.h"
+
+/**
+ * struct tombitem - entry of a tombstone test tree
+ * @i: key of the entry
+ * @tnode: node in the tombstone tree
+ * @dropped: entry was removed by a compaction
+ */
+struct tombitem {
+	uint16_t i;
+	struct rb_tnode tnode;
+	uint8_t dropped;
+};
+
+static uint16_t values[256];
+static uint16_t delete_items[ARRAY_SIZE(values)];
+static uint8_t skiplist[ARRAY_SIZE(values)];
+
+static struct tombitem items[ARRAY_SIZE(values)];
+static struct tombitem reinserted[ARRAY_SIZE(values)];
+
+static int tombitem_cmp(const struct rb_node *node1,
+			const struct rb_node *node2)
+{
+	const struct tombitem *item1;
+	const struct tombitem *item2;
+
+	item1 = rb_entry(node1, struct tombitem, tnode.rb);
+	item2 = rb_entry(node2, struct tombitem, tnode.rb);
+
+	return cmpint(&item1->i, &item2->i);
+}
+
+static int tombitem_cmpkey(const void *key, const struct rb_node *node)
+{
+	const struct tombitem *item = rb_entry(node, struct tombitem, tnode.rb);
+
+	return cmpint(key, &item->i);
+}
+
+static void drop_item(struct rb_tnode *tnode, void *arg)
+{
+	struct tombitem *item = container_of(tnode, struct tombitem, tnode);
+	size_t *dropped = (size_t *)arg;
+
+	assert(tnode->dead);
+	assert(!item->dropped);
+	item->dropped = 1;
+	(*dropped)++;
+}
+
+static void check_troot(struct rb_troot *troot)
+{
+	const struct tombitem *item;
+	struct rb_tnode *tnode;
+	struct rb_tnode *prev = NULL;
+	struct rb_shape shape;
+	size_t count = 0;
+	uint16_t key;
+
+	check_depth(&troot->root);
+	check_llrb_nodes(&troot->root);
+
+	rb_get_shape(&troot->root, &shape);
+	assert(shape.size == troot->live + troot->dead);
+
+	for (tnode = rb_tomb_first(troot); tnode; tnode = rb_tomb_next(tnode)) {
+		item = rb_entry(tnode, struct tombitem, tnode);
+		assert(!tnode->dead);
+		assert(!skiplist[item->i]);
+		assert(!prev || rb_tomb_next(prev) == tnode);
+		assert(rb_tomb_prev(tnode) == prev);
+		prev = tnode;
+		count++;
+	}
+	assert(rb_tomb_last(troot) == prev);
+	assert(count == troot->live);
+
+	for (key = 0; key < ARRAY_SIZE(skiplist); key++) {
+		tnode = rb_tomb_find(troot, &key, tombitem_cmpkey);
+		if (skiplist[key]) {
+			assert(!tnode);
+			continue;
+		}
+
+		assert(tnode);
+		assert(rb_entry(tnode, struct tombitem, tnode)->i == key);
+	}
+}
+
+int main(void)
+{
+	struct rb_troot troot;
+	struct tombitem *item;
+	size_t dropped;
+	size_t total;
+	size_t dead;
+	size_t i, j;
+	uint16_t key;
+
+	for (i = 0; i < 64; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+		memset(skiplist, 1, sizeof(skiplist));
+		memset(items, 0, sizeof(items));
+		memset(reinserted, 0, sizeof(reinserted));
+		dropped = 0;
+		dead = 0;
+
+		rb_tomb_init(&troot, (unsigned int)(10 + i));
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			items[j].i = values[j];
+			rb_tomb_insert(&troot, &items[j].tnode, tombitem_cmp);
+			skiplist[values[j]] = 0;
+		}
+		check_troot(&troot);
+
+		random_shuffle_array(delete_items,
+				     (uint16_t)ARRAY_SIZE(delete_items));
+		for (j = 0; j < ARRAY_SIZE(delete_items); j++) {
+			item = &items[delete_items[j]];
+			key = item->i;
+			skiplist[key] = 1;
+			dead++;
+
+			if (rb_tomb_erase(&troot, &item->tnode)) {
+				total = troot.live + troot.dead;
+				assert(troot.dead * 100 >=
+				       total * troot.threshold);
+				assert(rb_tomb_compact(&troot, drop_item,
+						       &dropped) == 0);
+				assert(dropped == dead);
+				assert(troot.dead == 0);
+			}
+
+			/* live entry next to a tombstone with the same key */
+			if (j % 4 == 0) {
+				reinserted[key].i = key;
+				rb_tomb_insert(&troot, &reinserted[key].tnode,
+					       tombitem_cmp);
+				skiplist[key] = 0;
+			}
+
+			check_troot(&troot);
+		}
+
+		assert(rb_tomb_compact(&troot, drop_item, &dropped) == 0);
+		assert(dropped == dead);
+		assert(troot.dead == 0);
+		check_troot(&troot);
+	}
+
+	return 0;
+}
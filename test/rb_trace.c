@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: MIT
+/* Minimal red-black-tree helper functions test
+ *
+ * SPDX-FileCopyrightText: Sven Eckelmann <sven@narfation.org>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../rbtree.h"
+#include "common.h"
+#include "common-treeops.h"
+
+static uint16_t values[256];
+
+static struct rbitem items[ARRAY_SIZE(values)];
+
+static unsigned long hist_samples(enum rb_trace_op op)
+{
+	struct rb_latency_hist hist;
+	unsigned long samples = 0;
+	size_t i;
+
+	rb_latency_get(op, &hist);
+	for (i = 0; i < RB_LATENCY_BUCKETS; i++)
+		samples += hist.count[i];
+
+	return samples;
+}
+
+int main(void)
+{
+	struct rb_root root;
+	struct rb_node *node;
+	size_t i, j;
+
+	/* buckets must be sorted and without gaps */
+	assert(rb_latency_bucket_value(0) == 0);
+	for (i = 1; i < RB_LATENCY_BUCKETS; i++)
+		assert(rb_latency_bucket_value(i) > rb_latency_bucket_value(i - 1));
+
+	for (i = 0; i < 16; i++) {
+		random_shuffle_array(values, (uint16_t)ARRAY_SIZE(values));
+
+		/* sample all operations */
+		rb_trace_set_sample_rate(1);
+		rb_latency_reset();
+
+		INIT_RB_ROOT(&root);
+		for (j = 0; j < ARRAY_SIZE(values); j++) {
+			items[j].i = values[j];
+			rbitem_insert(&root, &items[j]);
+		}
+
+		for (node = rb_first(&root); node; node = rb_next(node))
+			;
+
+		assert(hist_samples(RB_TRACE_INSERT) == ARRAY_SIZE(values));
+		assert(hist_samples(RB_TRACE_NEXT) == ARRAY_SIZE(values));
+		assert(hist_samples(RB_TRACE_ERASE) == 0);
+
+		/* sample only every 4th operation */
+		rb_trace_set_sample_rate(4);
+		rb_latency_reset();
+
+		for (j = 0; j < ARRAY_SIZE(values); j++)
+			rb_erase(&items[j].rb, &root);
+
+		assert(hist_samples(RB_TRACE_INSERT) == 0);
+		assert(hist_samples(RB_TRACE_ERASE) == ARRAY_SIZE(values) / 4);
+	}
+
+	return 0;
+}